@@ -0,0 +1,90 @@
+/*
+ * \brief  Block cache beneath the FUSE file-system backends
+ * \author agent
+ * \date   2026-10-19
+ *
+ * The FUSE backends access the block device through plain libc I/O on
+ * '/dev/blkdev'. The functions below take the place of these libc calls
+ * in the device-I/O code of the backends. Descriptors of the block device
+ * are served from a set-associative cache with sequential read-ahead and
+ * write-back, all other descriptors are passed through to the libc.
+ *
+ * The device-I/O sources of a backend are compiled with
+ *
+ *   -include fuse_block_cache.h -DFUSE_BLOCK_CACHE_REDIRECT
+ *
+ * to redirect their libc calls.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__FUSE_BLOCK_CACHE_H_
+#define _INCLUDE__FUSE_BLOCK_CACHE_H_
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int     fuse_block_open(const char *path, int flags, ...);
+int     fuse_block_close(int fd);
+ssize_t fuse_block_pread(int fd, void *buf, size_t count, off_t offset);
+ssize_t fuse_block_pwrite(int fd, const void *buf, size_t count, off_t offset);
+ssize_t fuse_block_read(int fd, void *buf, size_t count);
+ssize_t fuse_block_write(int fd, const void *buf, size_t count);
+off_t   fuse_block_lseek(int fd, off_t offset, int whence);
+int     fuse_block_fsync(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef FUSE_BLOCK_CACHE_REDIRECT
+#define open(...)                 fuse_block_open(__VA_ARGS__)
+#define close(fd)                 fuse_block_close(fd)
+#define pread(fd, buf, n, off)    fuse_block_pread(fd, buf, n, off)
+#define pwrite(fd, buf, n, off)   fuse_block_pwrite(fd, buf, n, off)
+#define read(fd, buf, n)          fuse_block_read(fd, buf, n)
+#define write(fd, buf, n)         fuse_block_write(fd, buf, n)
+#define lseek(fd, off, whence)    fuse_block_lseek(fd, off, whence)
+#define fsync(fd)                 fuse_block_fsync(fd)
+#endif /* FUSE_BLOCK_CACHE_REDIRECT */
+
+#ifdef __cplusplus
+
+namespace Fuse {
+
+	struct Block_cache_stats
+	{
+		unsigned long long hits;
+		unsigned long long misses;
+		unsigned long long read_ahead;    /* blocks fetched ahead of use */
+		unsigned long long device_reads;  /* requests to the device */
+		unsigned long long device_writes;
+		unsigned long long written;       /* dirty blocks written back */
+		unsigned long long evictions;     /* of dirty blocks */
+		unsigned           dirty;         /* blocks not yet written back */
+	};
+
+	/**
+	 * Write back all dirty blocks of the block device
+	 *
+	 * To be called from 'Fuse::sync_fs' after the file system has flushed
+	 * its own metadata.
+	 */
+	void block_cache_sync();
+
+	Block_cache_stats block_cache_stats();
+}
+
+#endif /* __cplusplus */
+
+#endif /* _INCLUDE__FUSE_BLOCK_CACHE_H_ */
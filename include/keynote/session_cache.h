@@ -0,0 +1,109 @@
+/*
+ * \brief  Cache of KeyNote sessions with pre-parsed assertions
+ * \author agent
+ * \date   2026-10-19
+ *
+ * Parsing assertions and verifying the signatures of credentials are the
+ * expensive parts of a KeyNote query. The cache keeps one KeyNote session
+ * per distinct set of policy and credential assertions. A query with
+ * assertions that were seen before only adds the action authorizer and
+ * the action attributes to the existing session. KeyNote retains the
+ * outcome of signature verification within a session, so credentials are
+ * verified only once.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__KEYNOTE__SESSION_CACHE_H_
+#define _INCLUDE__KEYNOTE__SESSION_CACHE_H_
+
+namespace Keynote {
+
+	struct Action;
+	class  Session_cache;
+}
+
+
+/**
+ * Action attribute of a query
+ */
+struct Keynote::Action
+{
+	char const *name;
+	char const *value;
+};
+
+
+class Keynote::Session_cache
+{
+	public:
+
+		struct Stats
+		{
+			unsigned long hits;
+			unsigned long misses;
+			unsigned long evictions;
+		};
+
+		enum { DEFAULT_CAPACITY = 16 };
+
+		struct Entry;
+
+	private:
+
+		Entry         *_entries;
+		unsigned const _capacity;
+		unsigned long  _clock = 0;
+		Stats          _stats { 0, 0, 0 };
+
+		Entry *_lookup(char const *policy, char const *credentials);
+		Entry *_create(char const *policy, char const *credentials);
+
+		/*
+		 * Noncopyable
+		 */
+		Session_cache(Session_cache const &);
+		Session_cache &operator = (Session_cache const &);
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param capacity  maximum number of KeyNote sessions kept open,
+		 *                  the least recently used one is closed first
+		 */
+		Session_cache(unsigned capacity = DEFAULT_CAPACITY);
+
+		~Session_cache();
+
+		/**
+		 * Evaluate a query
+		 *
+		 * \param policy         policy assertions, not signed
+		 * \param credentials    signed credential assertions, may be empty
+		 * \param authorizer     key of the action authorizer
+		 * \param return_values  ordered return values of the query
+		 *
+		 * \return index into 'return_values', or -1 on error with
+		 *         'keynote_errno' set
+		 */
+		int query(char const *policy, char const *credentials,
+		          char const *authorizer,
+		          Action const *actions, unsigned num_actions,
+		          char **return_values, int num_return_values);
+
+		/**
+		 * Close all sessions
+		 */
+		void flush();
+
+		Stats stats() const { return _stats; }
+};
+
+#endif /* _INCLUDE__KEYNOTE__SESSION_CACHE_H_ */
@@ -31,6 +31,20 @@ namespace Lwext4 {
 
 	void malloc_init(Genode::Env &, Genode::Allocator &heap);
 	struct ext4_blockdev *block_init(Genode::Env &, Genode::Allocator &heap);
+
+	/**
+	 * Statistics of the block-session backend
+	 */
+	struct Block_stats
+	{
+		unsigned long      reads           = 0;   /* requests */
+		unsigned long      writes          = 0;
+		unsigned long long blocks_read     = 0;   /* device blocks */
+		unsigned long long blocks_written  = 0;
+		unsigned           max_queue_depth = 0;   /* most packets in flight */
+	};
+
+	Block_stats const &block_stats();
 }
 
 #endif /* _INCLUDE__LWEXT4_INIT_H_ */
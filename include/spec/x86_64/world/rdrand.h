@@ -19,29 +19,71 @@
 
 namespace Genode { namespace Rdrand {
 
-	bool supported()
+	struct Features
 	{
-		unsigned int info[4] = {0, 0, 0, 0};
+		bool rdrand;
+		bool rdseed;
+	};
 
-		asm volatile("cpuid":"=a"(info[0]),"=b"(info[1]),"=c"(info[2]),"=d"(info[3]):"a"(1),"c"(0));
+	/**
+	 * Return CPU features, CPUID is executed only once
+	 */
+	static inline Features const &features()
+	{
+		static Features const features = [] () {
+			unsigned int a, b, c, d;
+
+			asm volatile("cpuid":"=a"(a),"=b"(b),"=c"(c),"=d"(d):"a"(0),"c"(0));
+			unsigned const max_leaf = a;
+
+			asm volatile("cpuid":"=a"(a),"=b"(b),"=c"(c),"=d"(d):"a"(1),"c"(0));
+
+			enum { RDRAND_MASK = 1U << 30, RDSEED_MASK = 1U << 18 };
+			bool const rdrand = c & RDRAND_MASK;
+
+			bool rdseed = false;
+			if (max_leaf >= 7) {
+				asm volatile("cpuid":"=a"(a),"=b"(b),"=c"(c),"=d"(d):"a"(7),"c"(0));
+				rdseed = b & RDSEED_MASK;
+			}
+			return Features { rdrand, rdseed };
+		}();
 
-		enum { RDRAND_MASK = 0x40000000 };
-		return (info[2] & RDRAND_MASK);
+		return features;
+	}
+
+	static inline bool supported()      { return features().rdrand; }
+	static inline bool seed_supported() { return features().rdseed; }
+
+	/*
+	 * RDRAND only fails if the DRNG is momentarily drained, a few retries
+	 * suffice. RDSEED draws from the entropy conditioner and fails much
+	 * more often under load, so it is retried longer with a pause.
+	 */
+	enum { RDRAND_RETRIES = 8, RDSEED_RETRIES = 128 };
+
+	static inline bool _rdrand_step(uint64_t &x)
+	{
+		unsigned char ok;
+		asm volatile("rdrand %0; setc %1":"=r"(x), "=qm"(ok));
+		return ok;
 	}
 
-#	define _rdrand_step(x) \
-	({ \
-		unsigned char err; \
-		asm volatile("rdrand %0; setc %1":"=r"(x), "=qm"(err)); \
-		err; \
-	}) \
+	static inline bool _rdseed_step(uint64_t &x)
+	{
+		unsigned char ok;
+		asm volatile("rdseed %0; setc %1":"=r"(x), "=qm"(ok));
+		return ok;
+	}
 
-	uint64_t random64()
+	/**
+	 * Read one word, count failed attempts in 'retries'
+	 */
+	static inline uint64_t random64(unsigned long &retries)
 	{
 		uint64_t result = 0;
 
-		enum { RETRIES = 8 };
-		for (int i = 0; i < RETRIES; i++)
+		for (int i = 0; i < RDRAND_RETRIES; i++, retries++)
 			if (_rdrand_step(result))
 				return result;
 
@@ -49,7 +91,84 @@ namespace Genode { namespace Rdrand {
 		throw Exception();
 	}
 
-#	undef _rdrand_step
+	static inline uint64_t seed64(unsigned long &retries)
+	{
+		uint64_t result = 0;
+
+		for (int i = 0; i < RDSEED_RETRIES; i++, retries++) {
+			if (_rdseed_step(result))
+				return result;
+			asm volatile("pause");
+		}
+
+		error("RDSEED failure");
+		throw Exception();
+	}
+
+	static inline uint64_t random64()
+	{
+		unsigned long retries = 0;
+		return random64(retries);
+	}
+
+	static inline uint64_t seed64()
+	{
+		unsigned long retries = 0;
+		return seed64(retries);
+	}
+
+	template <uint64_t (*STEP)(unsigned long &)>
+	static inline void _fill(void *dst, size_t len, unsigned long &retries)
+	{
+		char *p = (char *)dst;
+
+		/* four words per iteration */
+		for (; len >= 32; len -= 32, p += 32) {
+			uint64_t const w[4] { STEP(retries), STEP(retries),
+			                      STEP(retries), STEP(retries) };
+			__builtin_memcpy(p, w, sizeof(w));
+		}
+
+		for (; len >= 8; len -= 8, p += 8) {
+			uint64_t const w = STEP(retries);
+			__builtin_memcpy(p, &w, sizeof(w));
+		}
+
+		if (len) {
+			uint64_t const w = STEP(retries);
+			__builtin_memcpy(p, &w, len);
+		}
+	}
+
+	/**
+	 * Fill buffer with output of RDRAND
+	 *
+	 * \param retries  incremented by the number of failed attempts
+	 * \throw Exception  if RDRAND repeatedly fails
+	 */
+	static inline void fill(void *dst, size_t len, unsigned long &retries) {
+		_fill<random64>(dst, len, retries); }
+
+	static inline void fill(void *dst, size_t len)
+	{
+		unsigned long retries = 0;
+		fill(dst, len, retries);
+	}
+
+	/**
+	 * Fill buffer with output of RDSEED
+	 *
+	 * RDSEED provides full-entropy output suitable for seeding other
+	 * generators, at a lower rate than RDRAND.
+	 */
+	static inline void fill_seed(void *dst, size_t len, unsigned long &retries) {
+		_fill<seed64>(dst, len, retries); }
+
+	static inline void fill_seed(void *dst, size_t len)
+	{
+		unsigned long retries = 0;
+		fill_seed(dst, len, retries);
+	}
 
 } }
 
@@ -0,0 +1,27 @@
+/*
+ * \brief  Initialization of the Genode backend of TestU01
+ * \author agent
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__TESTU01__GENODE_INIT_H_
+#define _INCLUDE__TESTU01__GENODE_INIT_H_
+
+#include <timer_session/connection.h>
+#include <base/allocator.h>
+#include <base/log.h>
+
+/**
+ * Set the allocator and timer used by the library, must be called
+ * before any battery is applied
+ */
+void testu01_init(Genode::Allocator &heap, Timer::Connection &timer);
+
+#endif /* _INCLUDE__TESTU01__GENODE_INIT_H_ */
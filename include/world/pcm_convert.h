@@ -0,0 +1,190 @@
+/*
+ * \brief  Conversion of interleaved PCM frames to planar float channels
+ * \author agent
+ * \date   2026-10-19
+ *
+ * The Audio_out session expects one packet of 32-bit float samples per
+ * channel, whereas decoders and clients produce interleaved stereo frames.
+ * The kernels below deinterleave, convert, and scale such frames in one
+ * pass. On SSE2 and NEON targets four frames are processed per iteration
+ * using the GCC vector extension, all other targets and the remainder of a
+ * buffer use the scalar variant.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__WORLD__PCM_CONVERT_H_
+#define _INCLUDE__WORLD__PCM_CONVERT_H_
+
+#include <base/stdint.h>
+
+#if defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PCM_CONVERT_VECTOR 1
+#endif
+
+namespace Pcm {
+
+	using Genode::size_t;
+	using Genode::int16_t;
+
+	/**
+	 * Scale factor for converting signed 16-bit samples to [-1.0, 1.0)
+	 */
+	static constexpr float S16_SCALE = 1.0f / 32768.0f;
+
+	namespace Scalar {
+
+		/**
+		 * Deinterleave stereo float frames into two channel buffers
+		 *
+		 * \param left    destination of the left channel
+		 * \param right   destination of the right channel
+		 * \param src     interleaved source frames
+		 * \param frames  number of stereo frames to convert
+		 * \param volume  linear gain applied to each sample
+		 */
+		static inline void f32_to_planar(float *left, float *right,
+		                                 float const *src, size_t frames,
+		                                 float volume = 1.0f)
+		{
+			for (size_t i = 0; i < frames; ++i) {
+				left[i]  = volume * src[i*2];
+				right[i] = volume * src[i*2 + 1];
+			}
+		}
+
+		/**
+		 * Deinterleave and convert stereo signed 16-bit frames
+		 *
+		 * Parameters are the same as for 'f32_to_planar'.
+		 */
+		static inline void s16_to_planar(float *left, float *right,
+		                                 int16_t const *src, size_t frames,
+		                                 float volume = 1.0f)
+		{
+			float const scale = volume * S16_SCALE;
+			for (size_t i = 0; i < frames; ++i) {
+				left[i]  = scale * (float)src[i*2];
+				right[i] = scale * (float)src[i*2 + 1];
+			}
+		}
+	}
+
+#ifdef PCM_CONVERT_VECTOR
+
+	namespace Vector {
+
+		/*
+		 * The source and destination buffers are not necessarily 16-byte
+		 * aligned, hence the under-aligned vector types.
+		 */
+		typedef float   v4f __attribute__((vector_size(16), aligned(4), may_alias));
+		typedef int     v4i __attribute__((vector_size(16), aligned(4), may_alias));
+		typedef int16_t v8s __attribute__((vector_size(16), aligned(2), may_alias));
+
+		static inline void f32_to_planar(float *left, float *right,
+		                                 float const *src, size_t frames,
+		                                 float volume)
+		{
+			v4i const even = { 0, 2, 4, 6 };
+			v4i const odd  = { 1, 3, 5, 7 };
+			v4f const gain = { volume, volume, volume, volume };
+
+			size_t const blocks = frames / 4;
+			for (size_t i = 0; i < blocks; ++i) {
+				v4f const a = *(v4f const *)&src[i*8];
+				v4f const b = *(v4f const *)&src[i*8 + 4];
+
+				*(v4f *)&left[i*4]  = __builtin_shuffle(a, b, even) * gain;
+				*(v4f *)&right[i*4] = __builtin_shuffle(a, b, odd)  * gain;
+			}
+
+			size_t const done = blocks*4;
+			Scalar::f32_to_planar(left + done, right + done, src + done*2,
+			                      frames - done, volume);
+		}
+
+		static inline void s16_to_planar(float *left, float *right,
+		                                 int16_t const *src, size_t frames,
+		                                 float volume)
+		{
+			/*
+			 * Adding a 16-bit integer to the mantissa of 1.5 * 2^23 yields
+			 * a float whose value exceeds the magic number by exactly that
+			 * integer. This avoids a vector int-to-float conversion, which
+			 * the vector extension of our tool chain does not provide.
+			 */
+			enum { MAGIC_BITS = 0x4b400000 };
+			float const magic = 12582912.0f;
+
+			v4i const magic_bits = { MAGIC_BITS, MAGIC_BITS, MAGIC_BITS, MAGIC_BITS };
+			v4f const magic_f    = { magic, magic, magic, magic };
+
+			float const scale = volume * S16_SCALE;
+			v4f   const gain  = { scale, scale, scale, scale };
+
+			size_t const blocks = frames / 4;
+			for (size_t i = 0; i < blocks; ++i) {
+
+				/* four little-endian frames, one 32-bit lane per frame */
+				v4i const lanes = (v4i)*(v8s const *)&src[i*8];
+
+				/* sign-extend the low (left) and high (right) halves */
+				v4i const l = (lanes << 16) >> 16;
+				v4i const r =  lanes >> 16;
+
+				*(v4f *)&left[i*4]  = ((v4f)(l + magic_bits) - magic_f) * gain;
+				*(v4f *)&right[i*4] = ((v4f)(r + magic_bits) - magic_f) * gain;
+			}
+
+			size_t const done = blocks*4;
+			Scalar::s16_to_planar(left + done, right + done, src + done*2,
+			                      frames - done, volume);
+		}
+	}
+
+#endif /* PCM_CONVERT_VECTOR */
+
+	/**
+	 * Deinterleave stereo float frames into two channel buffers
+	 *
+	 * \param left    destination of the left channel
+	 * \param right   destination of the right channel
+	 * \param src     interleaved source frames
+	 * \param frames  number of stereo frames to convert
+	 * \param volume  linear gain applied to each sample
+	 */
+	static inline void f32_to_planar(float *left, float *right,
+	                                 float const *src, size_t frames,
+	                                 float volume = 1.0f)
+	{
+#ifdef PCM_CONVERT_VECTOR
+		Vector::f32_to_planar(left, right, src, frames, volume);
+#else
+		Scalar::f32_to_planar(left, right, src, frames, volume);
+#endif
+	}
+
+	/**
+	 * Deinterleave and convert stereo signed 16-bit frames
+	 *
+	 * Parameters are the same as for 'f32_to_planar'.
+	 */
+	static inline void s16_to_planar(float *left, float *right,
+	                                 int16_t const *src, size_t frames,
+	                                 float volume = 1.0f)
+	{
+#ifdef PCM_CONVERT_VECTOR
+		Vector::s16_to_planar(left, right, src, frames, volume);
+#else
+		Scalar::s16_to_planar(left, right, src, frames, volume);
+#endif
+	}
+}
+
+#endif /* _INCLUDE__WORLD__PCM_CONVERT_H_ */
@@ -22,12 +22,26 @@ namespace Genode { namespace Rdrand {
 	constexpr
 	bool supported() { return false; }
 
-	uint64_t random64()
+	constexpr
+	bool seed_supported() { return false; }
+
+	static inline void _not_available()
 	{
 		error("RDRAND not available on this architecture");
 		throw Exception();
 	}
 
+	static inline uint64_t random64() { _not_available(); return 0; }
+	static inline uint64_t seed64()   { _not_available(); return 0; }
+
+	static inline uint64_t random64(unsigned long &) { return random64(); }
+	static inline uint64_t seed64(unsigned long &)   { return seed64(); }
+
+	static inline void fill(void *, size_t)                      { _not_available(); }
+	static inline void fill(void *, size_t, unsigned long &)      { _not_available(); }
+	static inline void fill_seed(void *, size_t)                 { _not_available(); }
+	static inline void fill_seed(void *, size_t, unsigned long &) { _not_available(); }
+
 } }
 
 #endif /* _INCLUDE__OS__RDRAND_H_ */
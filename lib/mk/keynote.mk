@@ -23,7 +23,11 @@ SRC_C   = 	k.tab.c \
 		keynote-keygen.c\
 		keynote-main.c
 
+# session cache on top of the C API
+SRC_CC  = session_cache.cc
+
 CC_OPT = -O2 -w  -DCRYPTO -DHAVE_CONFIG_H
 vpath %.c $(KEYNOTE_DIR)
+vpath %.cc $(REP_DIR)/src/lib/keynote
 
 CC_CXX_WARN_STRICT =
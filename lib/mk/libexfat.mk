@@ -10,7 +10,11 @@ INC_DIR += $(REP_DIR)/include/exfat \
 
 #CC_OPT += -DHAVE_CONFIG_H -DRECORD_LOCKING_NOT_IMPLEMENTED
 
-LIBS += libc
+LIBS += libc libfuse
+
+# serve the block device from the libfuse block cache
+CC_OPT_io += -include $(REP_DIR)/include/fuse/fuse_block_cache.h \
+             -DFUSE_BLOCK_CACHE_REDIRECT
 
 vpath %.c $(EXFAT_DIR)/libexfat
 
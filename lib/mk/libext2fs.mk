@@ -21,7 +21,13 @@ CC_OPT += -Wno-unused-function -Wno-unused-variable \
 
 CC_C_OPT += -std=gnu89
 
-LIBS += libc
+LIBS += libc libfuse
+
+# serve the block device from the libfuse block cache
+BLOCK_CACHE_OPT    = -include $(REP_DIR)/include/fuse/fuse_block_cache.h \
+                     -DFUSE_BLOCK_CACHE_REDIRECT
+CC_OPT_unix_io    += $(BLOCK_CACHE_OPT)
+CC_OPT_llseek     += $(BLOCK_CACHE_OPT)
 
 vpath %.c $(EXT2FS_DIR)
 vpath %.c $(ET_DIR)
@@ -1,4 +1,4 @@
-SRC_CC = fuse.cc
+SRC_CC = fuse.cc block_cache.cc
 
 INC_DIR += $(REP_DIR)/include/fuse
 
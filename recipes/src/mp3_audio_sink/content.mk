@@ -1,2 +1,8 @@
 SRC_DIR = src/app/mp3_audio_sink
 include $(GENODE_DIR)/repos/base/recipes/src/content.inc
+
+MIRROR_FROM_REP_DIR := include/world/pcm_convert.h
+content: $(MIRROR_FROM_REP_DIR)
+
+$(MIRROR_FROM_REP_DIR):
+	$(mirror_from_rep_dir)
@@ -1,4 +1,4 @@
-content: src/lib/sdl/target.mk lib/mk LICENSE
+content: src/lib/sdl/target.mk lib/mk include/world/pcm_convert.h LICENSE
 
 PORT_DIR := $(call port_dir,$(REP_DIR)/ports/sdl)
 
@@ -14,5 +14,9 @@ lib/mk:
 	mkdir -p $@
 	cp $(REP_DIR)/$@/sdl.mk $@
 
+include/world/pcm_convert.h:
+	mkdir -p $(dir $@)
+	cp $(REP_DIR)/$@ $@
+
 LICENSE:
 	cp $(PORT_DIR)/src/lib/sdl/COPYING $@
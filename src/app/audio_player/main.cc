@@ -20,6 +20,7 @@
 #include <util/retry.h>
 #include <util/xml_node.h>
 #include <audio_out_session/connection.h>
+#include <world/pcm_convert.h>
 
 /* local includes */
 #include <list.h>
@@ -153,13 +154,8 @@ struct Audio_player::Output
 				Genode::warning("less frame data read than expected");
 			}
 
-			float *left_content  = p[LEFT]->content();
-			float *right_content = p[RIGHT]->content();
-
-			for (unsigned i = 0; i < Audio_out::PERIOD; i++) {
-					left_content[i]  = tmp[i * NUM_CHANNELS + LEFT];
-					right_content[i] = tmp[i * NUM_CHANNELS + RIGHT];
-			}
+			Pcm::f32_to_planar(p[LEFT]->content(), p[RIGHT]->content(),
+			                   tmp, Audio_out::PERIOD);
 
 			for_each_channel([&] (int const i) { _out[i]->submit(p[i]); });
 
@@ -95,9 +95,14 @@ struct Blk_shred::Main
 		}
 
 		if (Genode::Rdrand::supported()) {
-			/* XOR in RDRAND */
-			pcg_init[0] ^= Genode::Rdrand::random64();
-			pcg_init[1] ^= Genode::Rdrand::random64();
+			/* XOR in RDSEED, or RDRAND if not available */
+			uint64_t buf[2];
+			if (Genode::Rdrand::seed_supported())
+				Genode::Rdrand::fill_seed(buf, sizeof(buf));
+			else
+				Genode::Rdrand::fill(buf, sizeof(buf));
+			pcg_init[0] ^= buf[0];
+			pcg_init[1] ^= buf[1];
 		}
 
 		/* low bit must be set */
@@ -22,11 +22,14 @@
  *
  */
 
+#include <base/attached_dataspace.h>
 #include <base/heap.h>
-#include <base/registry.h>
+#include <dataspace/client.h>
 #include <libc/component.h>
 #include <region_map/client.h>
 #include <rm_session/connection.h>
+#include <rom_session/connection.h>
+#include <util/avl_tree.h>
 #include <util/retry.h>
 #include <base/debug.h>
 
@@ -1709,6 +1712,8 @@ void os::get_summary_cpu_info(char* buf, size_t buflen) {
 	NOT_IMPL;
 }
 
+static void print_vm_statistics(outputStream* st);
+
 void os::print_memory_info(outputStream* st) {
 
   st->print("Memory:");
@@ -1719,6 +1724,8 @@ void os::print_memory_info(outputStream* st) {
   st->print("(" UINT64_FORMAT "k free)",
             os::available_memory() >> 10);
   st->cr();
+
+  print_vm_statistics(st);
 }
 
 static void print_signal_handler(outputStream* st, int sig,
@@ -2256,18 +2263,59 @@ bool os::Bsd::hugetlbfs_sanity_check(bool warn, size_t page_size) {
 
 static size_t _large_page_size = 0;
 
+/*
+ * There are no explicit large pages on Genode. Instead, reservations are
+ * aligned to the large-page size and commits are served from dataspaces
+ * of multiples of this size, which core allocates naturally aligned and
+ * the kernel may map using superpages.
+ */
 void os::large_page_init() {
+  if (!UseLargePages) {
+    _large_page_size = 0;
+    return;
+  }
+
+  enum { DEFAULT_LARGE_PAGE_SIZE = 2*1024*1024 };
+
+  _large_page_size = DEFAULT_LARGE_PAGE_SIZE;
+  if (!FLAG_IS_DEFAULT(LargePageSizeInBytes)) {
+    if (is_power_of_2(LargePageSizeInBytes) &&
+        LargePageSizeInBytes > (size_t)vm_page_size())
+      _large_page_size = LargePageSizeInBytes;
+    else
+      warning("LargePageSizeInBytes " SIZE_FORMAT " invalid, using " SIZE_FORMAT,
+              LargePageSizeInBytes, _large_page_size);
+  }
+
+  _page_sizes[0] = _large_page_size;
+  _page_sizes[1] = vm_page_size();
+  _page_sizes[2] = 0;
+
+  Genode::log("using large pages of ", _large_page_size >> 10, " KiB");
 }
 
 
+/*
+ * Reserve and commit a large-page backed region at once
+ */
 char* os::reserve_memory_special(size_t bytes, size_t alignment, char* req_addr, bool exec) {
-  NOT_IMPL;
-  return nullptr;
+  if (!_large_page_size || req_addr)
+    return nullptr;
+
+  char *addr = pd_reserve_memory(bytes, nullptr, MAX2(alignment, _large_page_size));
+  if (!addr)
+    return nullptr;
+
+  if (!pd_commit_memory(addr, bytes, _large_page_size, exec)) {
+    pd_release_memory(addr, bytes);
+    return nullptr;
+  }
+
+  return addr;
 }
 
 bool os::release_memory_special(char* base, size_t bytes) {
-	NOT_IMPL;
-	return false;
+  return pd_release_memory(base, bytes);
 }
 
 size_t os::large_page_size() {
@@ -2278,11 +2326,11 @@ size_t os::large_page_size() {
 // with SysV SHM the entire memory region must be allocated as shared
 // memory.
 bool os::can_commit_large_page_memory() {
-  return UseHugeTLBFS;
+  return UseLargePages;
 }
 
 bool os::can_execute_large_page_memory() {
-  return UseHugeTLBFS;
+  return UseLargePages;
 }
 
 
@@ -3443,6 +3491,7 @@ void os::os_exception_wrapper(java_call_t f, JavaValue* value,
 }
 
 void os::print_statistics() {
+  print_vm_statistics(tty);
 }
 
 bool os::message_box(const char* title, const char* message) {
@@ -3628,6 +3677,9 @@ int os::available(int fd, jlong *bytes) {
   return 1;
 }
 
+static bool map_rom(const char* file_name, size_t file_offset, char* addr,
+                    size_t bytes, bool allow_exec);
+
 // Map a block of memory.
 char* os::pd_map_memory(int fd, const char* file_name, size_t file_offset,
                         char *addr, size_t bytes, bool read_only,
@@ -3635,6 +3687,9 @@ char* os::pd_map_memory(int fd, const char* file_name, size_t file_offset,
   int prot;
   int flags;
 
+  if (read_only && map_rom(file_name, file_offset, addr, bytes, allow_exec))
+    return addr;
+
   if (read_only) {
     prot = PROT_READ;
     flags = MAP_SHARED;
@@ -4357,20 +4412,25 @@ class Genode::Vm_region_map
 
 		void free_region(addr_t vaddr) { _range.free((void *)vaddr); }
 
-		Local_addr attach_at(Dataspace_capability ds, addr_t local_addr)
+		size_t region_size(addr_t vaddr) const {
+			return _range.size_at((void const *)vaddr); }
+
+		Local_addr attach_at(Dataspace_capability ds, addr_t local_addr,
+		                     size_t size = 0, off_t offset = 0)
 		{
 			return retry<Genode::Out_of_ram>(
 				[&] () {
-					return _rm.attach_at(ds, local_addr - _base);
+					return _rm.attach_at(ds, local_addr - _base, size, offset);
 				},
 				[&] () { _env.upgrade(Parent::Env::pd(), "ram_quota=8K"); });
 		}
 
-		Local_addr attach_executable(Dataspace_capability ds, addr_t local_addr)
+		Local_addr attach_executable(Dataspace_capability ds, addr_t local_addr,
+		                             size_t size = 0, off_t offset = 0)
 		{
 			return retry<Genode::Out_of_ram>(
 				[&] () {
-					return _rm.attach_executable(ds, local_addr - _base);
+					return _rm.attach_executable(ds, local_addr - _base, size, offset);
 				},
 				[&] () { _env.upgrade(Parent::Env::pd(), "ram_quota=8K"); });
 		}
@@ -4378,87 +4438,470 @@ class Genode::Vm_region_map
 		void detach(Local_addr local_addr) { _rm.detach((addr_t)local_addr - _base); }
 };
 
-class Genode::Vm_area
+namespace Genode {
+
+	/**
+	 * Return lowest node of an AVL tree of disjoint ranges that intersects
+	 * the range [base, base + size)
+	 */
+	template <typename T>
+	static T *lowest_intersecting(T *node, addr_t base, size_t size)
+	{
+		T *result = nullptr;
+		while (node) {
+			if (node->intersects(base, size)) {
+				result = node;
+				node   = node->child(Avl_node_base::LEFT);
+			} else
+				node = node->child(node->end() <= base ? Avl_node_base::RIGHT
+				                                       : Avl_node_base::LEFT);
+		}
+		return result;
+	}
+
+	struct Vm_stats
+	{
+		unsigned long commits       = 0; /* commit requests */
+		unsigned long batched       = 0; /* requests served by earlier commits */
+		unsigned long uncommits     = 0;
+		size_t        kept          = 0; /* uncommitted bytes not freed, in total */
+		unsigned long allocations   = 0; /* dataspaces allocated in total */
+		unsigned long dataspaces    = 0; /* dataspaces currently attached */
+		size_t        backed        = 0; /* bytes currently backed by RAM */
+		uint64_t      commit_us     = 0; /* accumulated commit latency */
+		uint64_t      commit_us_max = 0;
+		unsigned long rom_mappings  = 0; /* file ranges mapped from ROM */
+	};
+}
+
+class Genode::Vm_area : public Avl_node<Vm_area>
 {
 	private:
 
-		struct Vm_area_ds
+		struct Vm_area_ds : Avl_node<Vm_area_ds>
 		{
-				addr_t                   base;
-				size_t                   size;
-				Ram_dataspace_capability ds;
+				addr_t                   const base;
+				size_t                   const size;
+				Ram_dataspace_capability const ds;
+				bool                     const executable;
 
-				Vm_area_ds(addr_t base, size_t size, Ram_dataspace_capability ds)
-				: base(base), size(size), ds(ds) { }
+				/* ROM session of a mapped file, 'ds' is invalid in this case */
+				Rom_connection          *const rom;
 
-				virtual ~Vm_area_ds() { };
-		};
+				Vm_area_ds(addr_t base, size_t size, Ram_dataspace_capability ds,
+				           bool executable, Rom_connection *rom = nullptr)
+				: base(base), size(size), ds(ds), executable(executable),
+				  rom(rom) { }
 
-		typedef Registered<Vm_area_ds> Vm_handle;
+				addr_t end() const { return base + size; }
+
+				bool intersects(addr_t b, size_t s) const {
+					return b < end() && b + s > base; }
+
+				/* AVL node interface */
+				bool higher(Vm_area_ds *other) { return other->base >= base; }
+		};
 
 		Env                &_env;
 		Heap               &_heap;
 		Vm_region_map      &_rm;
-		size_t        const _base;
-		addr_t        const _size;
-		Registry<Vm_handle> _ds;
+		Vm_stats           &_stats;
+		addr_t              _base;
+		size_t              _size;
+
+		/* block of the region allocator this area was carved from */
+		addr_t        const _region;
+
+		Avl_tree<Vm_area_ds> _ds;
+
+		bool _attach(Dataspace_capability ds, addr_t base, bool executable,
+		             size_t size = 0, off_t offset = 0)
+		{
+			try {
+				if (executable)
+					_rm.attach_executable(ds, base, size, offset);
+				else
+					_rm.attach_at(ds, base, size, offset);
+			} catch (...) {
+				return false;
+			}
+			return true;
+		}
+
+		/**
+		 * Return first committed dataspace intersecting the given range
+		 */
+		Vm_area_ds *_lookup(addr_t base, size_t size) {
+			return lowest_intersecting(_ds.first(), base, size); }
+
+		void _insert(addr_t base, size_t size, Ram_dataspace_capability ds,
+		             bool executable)
+		{
+			_ds.insert(new (_heap) Vm_area_ds(base, size, ds, executable));
+			_stats.dataspaces++;
+			_stats.backed += size;
+		}
+
+		void _free(Vm_area_ds &vm)
+		{
+			_rm.detach(vm.base);
+			_ds.remove(&vm);
+
+			if (vm.rom) {
+				destroy(_heap, vm.rom);
+				_stats.rom_mappings--;
+			} else {
+				_env.ram().free(vm.ds);
+				_stats.dataspaces--;
+				_stats.backed -= vm.size;
+			}
+			destroy(_heap, &vm);
+		}
+
+		bool _commit(addr_t base, size_t size, bool executable)
+		{
+			Ram_dataspace_capability ds = _env.ram().alloc(size);
+
+			if (!_attach(ds, base, executable)) {
+				_env.ram().free(ds);
+				return false;
+			}
+
+			_insert(base, size, ds, executable);
+			_stats.allocations++;
+
+			return true;
+		}
+
+		/**
+		 * Back a range that is not committed yet
+		 *
+		 * If 'large_page' is not zero, the part of the range aligned to
+		 * 'large_page' is backed by one dataspace of a multiple of this
+		 * size. Core allocates such a dataspace naturally aligned, so the
+		 * kernel is able to map it with superpages.
+		 */
+		bool _commit_gap(addr_t base, addr_t end, bool executable,
+		                 size_t large_page)
+		{
+			if (large_page) {
+				addr_t const body_base = align_addr(base, log2(large_page));
+				addr_t const body_end  = end & ~(addr_t)(large_page - 1);
+
+				if (body_base < body_end) {
+					if (body_base > base
+					 && !_commit(base, body_base - base, executable))
+						return false;
+
+					if (!_commit(body_base, body_end - body_base, executable)) {
+						if (body_base > base) uncommit(base, body_base - base);
+						return false;
+					}
+
+					if (end > body_end
+					 && !_commit(body_end, end - body_end, executable)) {
+						uncommit(base, body_end - base);
+						return false;
+					}
+					return true;
+				}
+			}
+
+			return _commit(base, end - base, executable);
+		}
+
+		/**
+		 * Replace a dataspace by copies of its parts outside of [base, end)
+		 *
+		 * The dataspace is detached while its content is copied, so threads
+		 * accessing the kept parts meanwhile block until the copies are
+		 * attached at the same addresses.
+		 *
+		 * \return false if the copies could not be allocated or attached,
+		 *         'vm' is left unchanged in this case
+		 */
+		bool _split(Vm_area_ds &vm, addr_t base, addr_t end)
+		{
+			addr_t const vm_base = vm.base;
+			bool   const exec    = vm.executable;
+			size_t const head    = vm_base < base ? base - vm_base : 0;
+			size_t const tail    = vm.end() > end ? vm.end() - end : 0;
+
+			Ram_dataspace_capability head_ds, tail_ds;
+
+			auto free_copies = [&] () {
+				if (head_ds.valid()) _env.ram().free(head_ds);
+				if (tail_ds.valid()) _env.ram().free(tail_ds);
+			};
+
+			try {
+				if (head) head_ds = _env.ram().alloc(head);
+				if (tail) tail_ds = _env.ram().alloc(tail);
+
+				Attached_dataspace                original(_env.rm(), vm.ds);
+				Constructible<Attached_dataspace> head_copy, tail_copy;
+
+				if (head) head_copy.construct(_env.rm(), head_ds);
+				if (tail) tail_copy.construct(_env.rm(), tail_ds);
+
+				_rm.detach(vm_base);
+
+				if (head)
+					Genode::memcpy(head_copy->local_addr<char>(),
+					               original.local_addr<char>(), head);
+				if (tail)
+					Genode::memcpy(tail_copy->local_addr<char>(),
+					               original.local_addr<char>() + (end - vm_base),
+					               tail);
+			} catch (...) {
+				free_copies();
+				return false;
+			}
+
+			bool const head_attached = !head || _attach(head_ds, vm_base, exec);
+			bool const tail_attached = head_attached
+			                        && (!tail || _attach(tail_ds, end, exec));
+
+			if (!tail_attached) {
+				if (head && head_attached) _rm.detach(vm_base);
+				if (!_attach(vm.ds, vm_base, exec))
+					error(__func__, ": could not restore dataspace at ", Hex(vm_base));
+				free_copies();
+				return false;
+			}
+
+			_ds.remove(&vm);
+			_env.ram().free(vm.ds);
+			_stats.dataspaces--;
+			_stats.backed -= vm.size;
+			destroy(_heap, &vm);
+
+			if (head) _insert(vm_base, head, head_ds, exec);
+			if (tail) _insert(end, tail, tail_ds, exec);
+			_stats.allocations += (head ? 1 : 0) + (tail ? 1 : 0);
+
+			return true;
+		}
 
 	public:
 
-		Vm_area(Env &env, Heap &heap, Vm_region_map &rm, addr_t base, size_t size)
-		: _env(env), _heap(heap), _rm(rm), _base(base), _size(size)
+		Vm_area(Env &env, Heap &heap, Vm_region_map &rm, Vm_stats &stats,
+		        addr_t base, size_t size, addr_t region)
+		: _env(env), _heap(heap), _rm(rm), _stats(stats), _base(base),
+		  _size(size), _region(region)
 		{ }
 
-		addr_t base()  const { return _base; }
-		size_t size()  const { return _size; }
+		addr_t base()   const { return _base; }
+		size_t size()   const { return _size; }
+		addr_t end()    const { return _base + _size; }
+		addr_t region() const { return _region; }
 
-		bool inside(addr_t base, size_t size) {
+		bool inside(addr_t base, size_t size) const {
 			return base >= _base && (base + size) <= (_base + _size); }
 
-		bool commit(addr_t base, size_t size, bool executable)
+		bool intersects(addr_t base, size_t size) const {
+			return base < end() && base + size > _base; }
+
+		/* AVL node interface */
+		bool higher(Vm_area *other) { return other->_base >= _base; }
+
+		/**
+		 * Commit backing store for the given range
+		 *
+		 * \param batch       granularity the range is widened to, such that
+		 *                    neighbouring commits end up in one dataspace
+		 * \param large_page  large-page size or zero, see '_commit_gap'
+		 *
+		 * Parts of the range that are already backed, e.g., by a preceding
+		 * widened commit, are left as they are.
+		 */
+		bool commit(addr_t base, size_t size, bool executable,
+		            size_t batch, size_t large_page)
 		{
 			if (!inside(base, size))
 				return false;
 
-			Ram_dataspace_capability ds = _env.ram().alloc(size);
+			addr_t from = base;
+			addr_t to   = base + size;
 
-			try {
-				if (executable)
-					_rm.attach_executable(ds, base);
-				else
-					_rm.attach_at(ds, base);
-			} catch (...) {
-				_env.ram().free(ds);
-				return false;
+			if (batch) {
+				from = max(_base, from & ~(addr_t)(batch - 1));
+				to   = min(end(), align_addr(to, log2(batch)));
 			}
 
-			new (_heap) Vm_handle(_ds, base, size, ds);
+			bool allocated = false;
+
+			for (addr_t cursor = from; cursor < to; ) {
+
+				Vm_area_ds *vm  = _lookup(cursor, to - cursor);
+				addr_t      gap = vm ? vm->base : to;
+
+				if (gap > cursor) {
+					if (!_commit_gap(cursor, gap, executable, large_page))
+						return false;
+					allocated = true;
+				}
+
+				/* an executable range must not be backed by data memory */
+				if (vm && executable && !vm->executable) {
+					error(__func__, ": ", Hex(vm->base), " not executable");
+					return false;
+				}
+
+				cursor = vm ? vm->end() : to;
+			}
+
+			if (!allocated)
+				_stats.batched++;
 
 			return true;
 		}
 
-		virtual ~Vm_area()
+		/**
+		 * Map part of a ROM module read-only into the given range
+		 *
+		 * The range must not be committed. The area takes the ownership
+		 * of the ROM connection.
+		 */
+		bool map_rom(addr_t base, size_t size, Rom_connection &rom,
+		             off_t offset, bool executable)
 		{
-			_ds.for_each([&] (Vm_handle &vm) {
+			if (!inside(base, size) || _lookup(base, size))
+				return false;
 
-				_rm.detach(vm.base);
-				_env.ram().free(vm.ds);
-				destroy(_heap, &vm);
-			});
+			if (!_attach(rom.dataspace(), base, executable, size, offset))
+				return false;
+
+			_ds.insert(new (_heap)
+				Vm_area_ds(base, size, Ram_dataspace_capability(), executable, &rom));
+			_stats.rom_mappings++;
+			return true;
+		}
+
+		/**
+		 * Return backing store of the given range to the RAM quota
+		 *
+		 * Dataspaces that lie completely within the range are detached
+		 * and freed. A dataspace that overlaps the range partially is
+		 * split, see '_split'.
+		 *
+		 * \param strict  fail if a dataspace cannot be split, otherwise
+		 *                it stays attached and the uncommitted part is
+		 *                cleared as freshly committed memory would be
+		 *
+		 * Partially covered ROM mappings are left as they are, or make
+		 * a strict uncommit fail.
+		 */
+		bool uncommit(addr_t base, size_t size, bool strict = false)
+		{
+			addr_t const end = base + size;
+
+			for (addr_t cursor = base; cursor < end; ) {
+
+				Vm_area_ds *vm = _lookup(cursor, end - cursor);
+				if (!vm) break;
+
+				cursor = vm->end();
+
+				if (vm->base >= base && vm->end() <= end) {
+					_free(*vm);
+					continue;
+				}
+
+				if (!vm->rom && _split(*vm, base, end))
+					continue;
+
+				if (strict) {
+					error(__func__, ": could not split dataspace at ", Hex(vm->base));
+					return false;
+				}
+
+				/* ROM mappings are read-only and keep the file content */
+				if (!vm->rom) {
+					addr_t const from = max(base, vm->base);
+					addr_t const to   = min(end,  vm->end());
+					Genode::memset((void *)from, 0, to - from);
+					_stats.kept += to - from;
+				}
+			}
+
+			return true;
+		}
+
+		/**
+		 * Remove range at the start or the end of the area
+		 *
+		 * The range must not be committed.
+		 */
+		void shrink(addr_t base, size_t size)
+		{
+			if (base == _base)
+				_base += size;
+			_size -= size;
+		}
+
+		/**
+		 * Hand over committed dataspaces at or above 'base' to 'other'
+		 */
+		void move_above(addr_t base, Vm_area &other)
+		{
+			while (Vm_area_ds *vm = _lookup(base, end() - base)) {
+				_ds.remove(vm);
+				other._ds.insert(vm);
+			}
+		}
+
+		~Vm_area()
+		{
+			while (Vm_area_ds *vm = _ds.first())
+				_free(*vm);
 		}
 };
 
 
 class Genode::Vm_area_registry
 {
+	public:
+
+		/*
+		 * Commits are widened to this granularity so that the many small
+		 * commits of, e.g., G1's auxiliary data structures are backed by
+		 * a few dataspaces instead of one dataspace each. Below
+		 * 'BATCH_MIN_QUOTA' of available RAM, commits are not widened.
+		 */
+		enum { COMMIT_BATCH    = 256*1024,
+		       BATCH_MIN_QUOTA = 64*COMMIT_BATCH };
+
 	private:
 
-		typedef Registered<Vm_area> Vm_area_handle;
+		Env               &_env;
+		Heap               _heap { _env.ram(), _env.rm() };
+		Avl_tree<Vm_area>  _areas;
+		Vm_region_map      _rm { _env, _heap };
+		Vm_stats           _stats;
+		Lock               _lock;
+
+		Vm_area *_lookup(addr_t base, size_t size) {
+			return lowest_intersecting(_areas.first(), base, size); }
+
+		void _destroy(Vm_area &vm)
+		{
+			addr_t const region = vm.region();
+			_areas.remove(&vm);
+			destroy(_heap, &vm);
 
-		Env                     &_env;
-		Heap                     _heap { _env.ram(), _env.rm() };
-		Registry<Vm_area_handle> _registry;
-		Vm_region_map            _rm { _env, _heap };
+			/* free virtual region once all of its areas are released */
+			if (!_lookup(region, _rm.region_size(region)))
+				_rm.free_region(region);
+		}
+
+		Vm_area &_create(addr_t base, size_t size, addr_t region)
+		{
+			Vm_area *vm = new (&_heap)
+				Vm_area(_env, _heap, _rm, _stats, base, size, region);
+			_areas.insert(vm);
+			return *vm;
+		}
 
 	public:
 
@@ -4471,52 +4914,196 @@ class Genode::Vm_area_registry
 				Genode::warning("vm_start set");
 				return 0;
 			}
+
+			Lock::Guard guard(_lock);
+
 			base = _rm.alloc_region(size, align);
-			Vm_area *vm = new (&_heap) Vm_area_handle(_registry, _env, _heap, _rm, base, size);
+			_create(base, size, base);
 			return base;
 		}
 
-		bool commit(addr_t base, size_t size, bool executable)
+		bool commit(addr_t base, size_t size, bool executable,
+		            size_t large_page = 0)
 		{
-			bool success = false;
+			uint64_t const start_us = os::javaTimeNanos() / 1000;
 
-			_registry.for_each([&] (Vm_area_handle &vm) {
-				if (success) return;
-				success = vm.commit(base, size, executable);
-			});
+			Lock::Guard guard(_lock);
+
+			Vm_area *vm = _lookup(base, size);
+			if (!vm || !vm->inside(base, size))
+				return false;
+
+			/* keep executable memory tight, it is rare and small */
+			bool const widen = !executable && !large_page
+			                && _env.pd().avail_ram().value >= BATCH_MIN_QUOTA;
+
+			size_t const batch = widen ? (size_t)COMMIT_BATCH
+			                   : executable ? 0 : large_page;
+
+			bool success = vm->commit(base, size, executable, batch,
+			                          large_page);
+
+			/* the widened range may not fit the quota the request fits */
+			if (!success && widen)
+				success = vm->commit(base, size, executable, 0, large_page);
+
+			uint64_t const duration_us = os::javaTimeNanos() / 1000 - start_us;
+
+			_stats.commits++;
+			_stats.commit_us    += duration_us;
+			_stats.commit_us_max = max(_stats.commit_us_max, duration_us);
 
 			return success;
 		}
 
+		bool uncommit(addr_t base, size_t size)
+		{
+			Lock::Guard guard(_lock);
+
+			bool found   = false;
+			bool success = true;
+
+			_stats.uncommits++;
+
+			for (addr_t cursor = base; cursor < base + size; ) {
+
+				Vm_area *vm = _lookup(cursor, base + size - cursor);
+				if (!vm) break;
+
+				addr_t const from = max(cursor, vm->base());
+				addr_t const to   = min(base + size, vm->end());
+
+				found    = true;
+				success &= vm->uncommit(from, to - from);
+				cursor   = to;
+			}
+
+			if (!found) error(__func__, " failed");
+
+			return found && success;
+		}
+
 		bool release(addr_t base, size_t size)
 		{
-			bool success = false;
+			Lock::Guard guard(_lock);
 
-			_registry.for_each([&] (Vm_area_handle &vm) {
-				if (success || !vm.inside(base, size)) return;
+			Vm_area *vm = _lookup(base, size);
 
-				if (base != vm.base() || size != vm.size()) {
-					error(__func__, " sub region release ", " addr: ", Hex(base), " vm addr: ", Hex(vm.base()),
-					      " size: ", Hex(size), " vm size: ", Hex(vm.size()));
-					while (1);
-				}
+			if (!vm || !vm->inside(base, size)) {
+				error(__func__, " failed");
+				return false;
+			}
 
-				_rm.free_region(vm.base());
-				destroy(_heap, &vm);
-				success = true;
-			});
+			if (base == vm->base() && size == vm->size()) {
+				_destroy(*vm);
+				return true;
+			}
 
-			if (!success) error(__func__, " failed");
+			/* a dataspace cannot be kept partly outside of its area */
+			if (!vm->uncommit(base, size, true))
+				return false;
 
-			return success;
+			/* sub region at the start or the end */
+			if (base == vm->base() || base + size == vm->end()) {
+				vm->shrink(base, size);
+				return true;
+			}
+
+			/* sub region in the middle, split area */
+			addr_t const upper_base = base + size;
+			size_t const upper_size = vm->end() - upper_base;
+
+			Vm_area &upper = _create(upper_base, upper_size, vm->region());
+
+			vm->move_above(upper_base, upper);
+			vm->shrink(base, vm->end() - base);
+			return true;
+		}
+
+		/**
+		 * Map a range of a ROM module into a reserved area
+		 *
+		 * ROM dataspaces are shared by all components that open the same
+		 * module, which avoids copying read-only files into RAM.
+		 */
+		bool map_rom(char const *name, addr_t base, size_t size, off_t offset,
+		             bool executable)
+		{
+			Lock::Guard guard(_lock);
+
+			Vm_area *vm = _lookup(base, size);
+			if (!vm || !vm->inside(base, size))
+				return false;
+
+			Rom_connection *rom = nullptr;
+			try {
+				rom = new (&_heap) Rom_connection(_env, name);
+
+				Dataspace_client ds(rom->dataspace());
+				if (offset + size <= ds.size()
+				 && vm->map_rom(base, size, *rom, offset, executable))
+					return true;
+			} catch (...) { }
+
+			if (rom) destroy(&_heap, rom);
+			return false;
+		}
+
+		Vm_stats stats()
+		{
+			Lock::Guard guard(_lock);
+			return _stats;
 		}
 };
 
 static Genode::Constructible<Genode::Vm_area_registry> vm_reg;
 
+
+static void print_vm_statistics(outputStream* st)
+{
+  Genode::Vm_stats const s = vm_reg->stats();
+
+  st->print_cr("Commits: %lu (%lu batched, %lu uncommits), "
+               "latency avg " JULONG_FORMAT " us max " JULONG_FORMAT " us",
+               s.commits, s.batched, s.uncommits,
+               (julong)(s.commits ? s.commit_us / s.commits : 0),
+               (julong)s.commit_us_max);
+  st->print_cr("Dataspaces: %lu (%lu allocated), backed " SIZE_FORMAT "k "
+               "(" SIZE_FORMAT "k kept on uncommit), %lu ROM mappings",
+               s.dataspaces, s.allocations, s.backed >> 10, s.kept >> 10,
+               s.rom_mappings);
+}
+
+
+/*
+ * Read-only file mappings are served from the ROM module of the same name
+ * if the file is a class-data-sharing archive, which is provided via a
+ * '<rom>' VFS node. The libc would otherwise copy the file into RAM.
+ */
+static bool map_rom(const char* file_name, size_t file_offset, char* addr,
+                    size_t bytes, bool allow_exec)
+{
+  if (!file_name || !addr)
+    return false;
+
+  size_t const len = strlen(file_name);
+  if (len < 4 || strcmp(file_name + len - 4, ".jsa") != 0)
+    return false;
+
+  char const *name = strrchr(file_name, '/');
+  name = name ? name + 1 : file_name;
+
+  return vm_reg->map_rom(name, (Genode::addr_t)addr, bytes,
+                         (Genode::off_t)file_offset, allow_exec);
+}
+
 char* os::pd_reserve_memory(size_t bytes, char* requested_addr,
                             size_t alignment_hint)
 {
+	/* align large reservations such that they can be backed by large pages */
+	if (_large_page_size && bytes >= _large_page_size)
+		alignment_hint = MAX2(alignment_hint, _large_page_size);
+
 	try {
 		Genode::addr_t addr =  vm_reg->reserve(bytes, (Genode::addr_t)requested_addr,
 		                       alignment_hint ? Genode::log2(alignment_hint) : 12);
@@ -4562,8 +5149,11 @@ bool os::pd_commit_memory(char* addr, size_t size, bool exec) {
 
 bool os::pd_commit_memory(char* addr, size_t size, size_t alignment_hint,
                           bool exec) {
-  // alignment_hint is ignored on this OS
-  return pd_commit_memory(addr, size, exec);
+	/* a hint of the large-page size denotes a large-page backed space */
+	if (!_large_page_size || alignment_hint < _large_page_size)
+		return pd_commit_memory(addr, size, exec);
+
+	return vm_reg->commit((Genode::addr_t)addr, size, exec, _large_page_size);
 }
 
 
@@ -4581,8 +5171,11 @@ void os::pd_commit_memory_or_exit(char* addr, size_t size, bool exec,
 void os::pd_commit_memory_or_exit(char* addr, size_t size,
                                   size_t alignment_hint, bool exec,
                                   const char* mesg) {
-  // alignment_hint is ignored on this OS
-  pd_commit_memory_or_exit(addr, size, exec, mesg);
+  assert(mesg != NULL, "mesg must be specified");
+  if (!pd_commit_memory(addr, size, alignment_hint, exec)) {
+    PRODUCT_ONLY(warn_fail_commit_memory(addr, size, exec, errno);)
+    vm_exit_out_of_memory(size, OOM_MMAP_ERROR, "%s", mesg);
+  }
 }
 
 
@@ -4592,16 +5185,7 @@ void os::pd_realign_memory(char *addr, size_t bytes, size_t alignment_hint) {
 
 
 bool os::pd_uncommit_memory(char* addr, size_t size) {
-  Genode::error(__PRETTY_FUNCTION__, "addr: ", (void *)addr, " size: ", (void *)size);
-  while (1);
-#ifdef __OpenBSD__
-  // XXX: Work-around mmap/MAP_FIXED bug temporarily on OpenBSD
-  return ::mprotect(addr, size, PROT_NONE) == 0;
-#else
-  uintptr_t res = (uintptr_t) ::mmap(addr, size, PROT_NONE,
-                                     MAP_PRIVATE|MAP_FIXED|MAP_ANONYMOUS, -1, 0);
-  return res  != (uintptr_t) MAP_FAILED;
-#endif
+  return vm_reg->uncommit((Genode::addr_t)addr, size);
 }
 
 
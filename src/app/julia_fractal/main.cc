@@ -36,12 +36,15 @@
 
 #include <base/component.h>
 #include <base/log.h>
+#include <base/semaphore.h>
+#include <base/thread.h>
 #include <os/pixel_rgb565.h>
+#include <os/reporter.h>
 #include <base/attached_dataspace.h>
+#include <base/attached_rom_dataspace.h>
 #include <timer_session/connection.h>
 #include <nitpicker_session/connection.h>
 #include <libc/component.h>
-#include <complex> // STL
 
 struct Painter_T {
   virtual ~Painter_T() = default;
@@ -109,11 +112,187 @@ public:
     _refresh();
   }
 
+  unsigned long pixels() const {
+    return (unsigned long)_mode.width() * _mode.height(); }
+
 };
 
-class julia : public Painter_T {
+/**
+ * Escape-time kernel computing the iteration counts of LANES pixels at once
+ *
+ * The lanes are doubles in a GCC vector, which maps to AVX, SSE2, or
+ * AArch64 NEON registers. Other targets use one lane.
+ */
+namespace escape_time {
+
+#if defined(__AVX__)
+#define ESCAPE_TIME_LANES 4
+#elif defined(__SSE2__) || defined(__aarch64__)
+#define ESCAPE_TIME_LANES 2
+#else
+#define ESCAPE_TIME_LANES 1
+#endif
+
+  enum { LANES = ESCAPE_TIME_LANES };
+
+  /**
+   * Iterate Z = Z*Z + c for a row of pixels sharing the imaginary part
+   *
+   * \param zr     real parts of the start values, one per lane
+   * \param zi     imaginary part of the start values
+   * \param c      real constant, the imaginary part is zero
+   * \param n      maximum number of iterations
+   * \param count  resulting number of iterations before escaping
+   */
+#if ESCAPE_TIME_LANES > 1
+
+  typedef double vd __attribute__((vector_size(LANES*sizeof(double))));
+
+  static inline void iterate(double const *zr, double zi, double c,
+                             unsigned n, unsigned *count)
+  {
+    vd r, i, cr, four;
+    for (unsigned l = 0; l < LANES; ++l)
+      r[l] = zr[l], i[l] = zi, cr[l] = c, four[l] = 4.0;
+
+    /* comparisons yield -1 in each lane where they hold */
+    decltype(r < r) iterations { }, active { };
+    active = ~active; /* all lanes start active */
+
+    for (unsigned k = 0; k < n; ++k) {
+      vd const r2 = r*r, i2 = i*i;
+
+      /* an escaped lane stays escaped, even if it comes back */
+      active &= (r2 + i2) < four;
+
+      bool any = false;
+      for (unsigned l = 0; l < LANES; ++l)
+        any |= (active[l] != 0);
+      if (!any)
+        break;
+
+      iterations -= active;
+      i = (r + r)*i;
+      r = r2 - i2 + cr;
+    }
+
+    for (unsigned l = 0; l < LANES; ++l)
+      count[l] = (unsigned)iterations[l];
+  }
+
+#else
+
+  static inline void iterate(double const *zr, double zi, double c,
+                             unsigned n, unsigned *count)
+  {
+    double r = zr[0], i = zi;
+    unsigned k = 0;
+    for (; k < n && (r*r + i*i) < 4.0; ++k) {
+      double const r2 = r*r, i2 = i*i;
+      i = (r + r)*i;
+      r = r2 - i2 + c;
+    }
+    count[0] = k;
+  }
+
+#endif
+}
+
+
+/**
+ * Worker pool that renders the tiles of a frame
+ *
+ * The thread calling 'run' works on tiles too, so a pool of N threads
+ * uses N-1 additional workers, one per CPU of the affinity space.
+ */
+class render_pool {
+public:
+  struct job_T {
+    virtual ~job_T() = default;
+    virtual void render_tile(unsigned idx) = 0;
+  };
+
+  enum { MAX_THREADS = 64 };
+
+private:
+  struct worker : Genode::Thread {
+    render_pool&      _pool;
+    Genode::Semaphore _start{0};
+
+    void entry() override {
+      for (;;) {
+        _start.down();
+        _pool._work();
+      }
+    }
+
+    worker(Genode::Env& env, render_pool& pool, Location location)
+      : Genode::Thread{env, "julia_worker", 8*1024*sizeof(long),
+                       location, Weight(), env.cpu()},
+        _pool{pool} { start(); }
+  };
+
+  Genode::Lock                  _lock{};
+  Genode::Semaphore             _done{0};
+  job_T*                        _job{nullptr};
+  unsigned                      _next{0};
+  unsigned                      _count{0};
+  unsigned                      _threads;
+  Genode::Constructible<worker> _workers[MAX_THREADS - 1];
+
+  bool _claim(unsigned& idx) {
+    Genode::Lock::Guard guard{_lock};
+    if (_next >= _count) return false;
+    idx = _next++;
+    return true;
+  }
+
+  void _work() {
+    unsigned idx;
+    while (_claim(idx))
+      _job->render_tile(idx);
+    _done.up();
+  }
+
+public:
+  render_pool(Genode::Env& env, unsigned threads)
+    : _threads{Genode::max(1U, Genode::min(threads, (unsigned)MAX_THREADS))}
+  {
+    auto const space = env.cpu().affinity_space();
+    for (unsigned i = 1; i < _threads; ++i)
+      _workers[i - 1].construct(env, *this, space.location_of_index(i));
+  }
+
+  unsigned threads() const { return _threads; }
+
+  /**
+   * Render 'count' tiles and return once all of them are done
+   */
+  void run(job_T& job, unsigned count) {
+    _job = &job, _next = 0, _count = count;
+
+    for (unsigned i = 1; i < _threads; ++i)
+      _workers[i - 1]->_start.up();
+
+    unsigned idx;
+    while (_claim(idx))
+      job.render_tile(idx);
+
+    for (unsigned i = 1; i < _threads; ++i)
+      _done.down();
+  }
+};
+
+
+class julia : public Painter_T, render_pool::job_T {
   using flt_t = double;
-  using cmplx = std::complex<flt_t>;
+
+  enum { TILE = 32 };
+
+  render_pool&          _pool;
+  Genode::Pixel_rgb565* _buf{nullptr};
+  unsigned              _w{0}, _h{0};
+
 public:
 
   /** Changed using direct assignment **/
@@ -121,34 +300,122 @@ public:
   unsigned           N;
 
   virtual ~julia() = default;
-  julia(flt_t c, unsigned n) :  C{c}, N{n} {}
+  julia(render_pool& pool, flt_t c, unsigned n) : _pool{pool}, C{c}, N{n} {}
 
   /**
-   * Draw a calculated set in the buffer. 
+   * Draw a calculated set in the buffer.
    */
   void paint(Genode::Pixel_rgb565* buf, unsigned w, unsigned h) override
   {
-    --w, --h;
-    const auto _w = w;
-    const auto _h = h;
-    Genode::size_t idx{0};
-    do do {
-	/// Scale pixels
-	cmplx    Z {w*3.5/_w - 1.75, h*2.0/_h - 1};
-	unsigned i {0};
-	for (; i < N && (Z.real()*Z.real() + Z.imag()*Z.imag()) < 4.0; ++i)
-	  Z = Z*Z + C;
-
-	unsigned c = ((i)*255) / N;
-	if (i < N) {
-	  double quotient = ((double) i) / N;
-	  if (quotient > 0.5)
-	    buf[idx++].rgba(255, c, c);
-	  else 
-	    buf[idx++].rgba(c, 0, 0);
-	} else buf[idx++].rgba(0, 0, 0);
-
-    } while (w-- > 0); while (w = _w, h-- > 0);
+    _buf = buf, _w = w, _h = h;
+
+    unsigned const tiles = ((w + TILE - 1)/TILE) * ((h + TILE - 1)/TILE);
+    _pool.run(*this, tiles);
+  }
+
+  /**
+   * Draw one tile, pixels are scaled such that the buffer origin shows
+   * the lower right corner of the set
+   */
+  void render_tile(unsigned idx) override
+  {
+    using escape_time::LANES;
+
+    unsigned const tiles_x = (_w + TILE - 1)/TILE;
+    unsigned const x0 = (idx % tiles_x)*TILE, x1 = Genode::min(x0 + TILE, _w);
+    unsigned const y0 = (idx / tiles_x)*TILE, y1 = Genode::min(y0 + TILE, _h);
+
+    flt_t const sw = Genode::max(_w, 2U) - 1;
+    flt_t const sh = Genode::max(_h, 2U) - 1;
+
+    for (unsigned y = y0; y < y1; ++y) {
+      flt_t const zi = (sh - y)*2.0/sh - 1;
+
+      for (unsigned x = x0; x < x1; x += LANES) {
+        flt_t    zr[LANES];
+        unsigned count[LANES];
+
+        for (unsigned l = 0; l < LANES; ++l)
+          zr[l] = (sw - (x + l))*3.5/sw - 1.75;
+
+        escape_time::iterate(zr, zi, C, N, count);
+
+        Genode::Pixel_rgb565* line = _buf + y*_w;
+        for (unsigned l = 0; l < LANES && x + l < x1; ++l) {
+          unsigned const i = count[l];
+          unsigned const c = (i*255) / N;
+          if (i < N) {
+            double quotient = ((double) i) / N;
+            if (quotient > 0.5)
+              line[x + l].rgba(255, c, c);
+            else
+              line[x + l].rgba(c, 0, 0);
+          } else line[x + l].rgba(0, 0, 0);
+        }
+      }
+    }
+  }
+};
+
+
+/**
+ * Measures render time and frame rate, and reports both periodically
+ */
+class frame_stats {
+  Genode::Reporter  _reporter;
+  Timer::Connection _timer;
+  unsigned const    _threads;
+  unsigned long     _frames{0};
+  unsigned long     _pixels{0};
+  Genode::uint64_t  _render_us{0};
+  Genode::uint64_t  _period_start_us{_now_us()};
+
+  enum { REPORT_PERIOD_US = 1000*1000 };
+
+  Genode::uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+  void _report(Genode::uint64_t period_us) {
+    using Genode::String;
+
+    double const fps     = (double)_frames * 1000000 / period_us;
+    double const mpixels = _render_us ? (double)_pixels / _render_us : 0;
+
+    Genode::Reporter::Xml_generator xml(_reporter, [&] () {
+      xml.attribute("threads", _threads);
+      xml.attribute("lanes", (unsigned)escape_time::LANES);
+      xml.attribute("frames", _frames);
+      xml.attribute("fps", String<16>(fps));
+      xml.attribute("render_us", _frames ? _render_us / _frames : 0);
+      xml.attribute("mpixels_per_s", String<16>(mpixels));
+    });
+  }
+
+public:
+  frame_stats(Genode::Env& env, bool report, unsigned threads)
+    : _reporter{env, "julia_stats"}, _timer{env}, _threads{threads} {
+      _reporter.enabled(report); }
+
+  /**
+   * Render a frame via 'fn' and account its time
+   */
+  template <typename Fn_T>
+  void measure(unsigned long pixels, Fn_T const& fn) {
+    Genode::uint64_t const start_us = _now_us();
+    fn();
+    Genode::uint64_t const now_us = _now_us();
+
+    _frames++;
+    _pixels    += pixels;
+    _render_us += now_us - start_us;
+
+    if (now_us - _period_start_us < REPORT_PERIOD_US)
+      return;
+
+    if (_reporter.enabled())
+      _report(now_us - _period_start_us);
+
+    _frames = 0, _pixels = 0, _render_us = 0;
+    _period_start_us = now_us;
   }
 };
 
@@ -176,16 +443,28 @@ public:
 
 
 void Libc::Component::construct(Libc::Env& env) {
-  static julia painter{-.75, 20};
+  static Genode::Attached_rom_dataspace config{env, "config"};
+
+  Genode::Xml_node const node = config.xml();
+
+  unsigned const cpus    = env.cpu().affinity_space().total();
+  unsigned const threads = node.attribute_value("threads", cpus);
+  unsigned const period  = node.attribute_value("period_ms", 15U);
+
+  static render_pool pool{env, threads};
+  static julia painter{pool, -.75, node.attribute_value("iterations", 20U)};
+  static frame_stats stats{env, node.attribute_value("report", false),
+                           pool.threads()};
   static window win{env, painter, "julia", Nitpicker::Area{256, 256}};
-  
+
   auto update_win = [&] {
     painter.C -= 0.003;
-    win.draw_next_frame();
+    stats.measure(win.pixels(), [&] { win.draw_next_frame(); });
   };
 
   /* Update the window's contents on a static interval. */
   static Timer_callback<decltype(update_win)>
-    window_update_timer{env, 15000, update_win};
-  Genode::log("constructed");
+    window_update_timer{env, Genode::max(period, 1U)*1000, update_win};
+  Genode::log("constructed, ", pool.threads(), " threads, ",
+              (unsigned)escape_time::LANES, " lanes");
 }
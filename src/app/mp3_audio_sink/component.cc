@@ -27,6 +27,7 @@
 #include <base/attached_rom_dataspace.h>
 #include <base/attached_ram_dataspace.h>
 #include <base/sleep.h>
+#include <world/pcm_convert.h>
 
 /* Mpg123 includes */
 #include <stdlib.h>
@@ -254,10 +255,8 @@ void Mp3_audio_sink::Decoder::submit_audio()
 		float const *content = _pcm.read_addr();
 
 		/* copy channel contents into sessions */
-		for (unsigned i = 0; i < STEREO_PERIOD; i += NUM_CHANNELS) {
-			for_each_channel([&] (int const c) {
-				p[c]->content()[i/NUM_CHANNELS] = content[i+c]; });
-		}
+		Pcm::f32_to_planar(p[LEFT]->content(), p[RIGHT]->content(),
+		                   content, Audio_out::PERIOD);
 
 		for_each_channel([&] (int const c) {
 			 _out[c]->submit(p[c]); });
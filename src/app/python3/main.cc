@@ -13,31 +13,275 @@
 
 /* Python includes */
 #include <python3/Python.h>
+#include <python3/marshal.h>
 
 /* Genode includes */
 #include <base/attached_rom_dataspace.h>
 #include <base/env.h>
+#include <base/heap.h>
 #include <libc/component.h>
 #include <base/log.h>
+#include <os/reporter.h>
+#include <timer_session/connection.h>
+#include <util/list.h>
 
 /* libc includes */
 #include <fcntl.h>
+#include <stdio.h>
 
 namespace Python
 {
 	struct Rom_watcher;
+	struct Code_cache;
 	struct Main;
+
+	using Genode::uint64_t;
+	using Genode::size_t;
 }
 
+
+/**
+ * Compiled code objects of a persistent interpreter
+ *
+ * Entries are keyed by the hash of the script source, so a script that
+ * did not change is neither parsed nor compiled again.
+ */
+struct Python::Code_cache
+{
+	struct Entry : Genode::List<Entry>::Element
+	{
+		uint64_t const hash;
+		size_t   const size;
+		PyObject      *code;
+
+		Entry(uint64_t hash, size_t size, PyObject *code)
+		: hash(hash), size(size), code(code) { }
+
+		~Entry() { Py_XDECREF(code); }
+	};
+
+	Genode::Allocator   &_alloc;
+	Genode::List<Entry>  _entries { };
+	unsigned             _count = 0;
+	unsigned const       _capacity;
+
+	unsigned long hits = 0, misses = 0;
+
+	/**
+	 * 64-bit FNV-1a hash
+	 */
+	static uint64_t hash(char const *data, size_t len)
+	{
+		uint64_t h = 0xcbf29ce484222325ULL;
+		for (size_t i = 0; i < len; ++i)
+			h = (h ^ (unsigned char)data[i]) * 0x100000001b3ULL;
+		return h;
+	}
+
+	Code_cache(Genode::Allocator &alloc, unsigned capacity)
+	: _alloc(alloc), _capacity(capacity ? capacity : 1) { }
+
+	~Code_cache()
+	{
+		while (Entry *e = _entries.first()) {
+			_entries.remove(e);
+			destroy(_alloc, e);
+		}
+	}
+
+	/**
+	 * Return borrowed reference to cached code object or nullptr
+	 */
+	PyObject *lookup(uint64_t hash, size_t size)
+	{
+		for (Entry *e = _entries.first(); e; e = e->next()) {
+			if (e->hash != hash || e->size != size) continue;
+
+			/* keep the most recently used entry at the front */
+			_entries.remove(e);
+			_entries.insert(e);
+			++hits;
+			return e->code;
+		}
+		++misses;
+		return nullptr;
+	}
+
+	/**
+	 * Insert code object, the cache takes over the reference
+	 */
+	void insert(uint64_t hash, size_t size, PyObject *code)
+	{
+		if (_count == _capacity) {
+			Entry *last = _entries.first();
+			while (last && last->next()) last = last->next();
+			if (last) {
+				_entries.remove(last);
+				destroy(_alloc, last);
+				--_count;
+			}
+		}
+		_entries.insert(new (_alloc) Entry(hash, size, code));
+		++_count;
+	}
+};
+
+
 struct Python::Main
 {
 	Genode::Env       &_env;
 
+	Genode::Heap _heap { _env.ram(), _env.rm() };
+
 	Genode::Attached_rom_dataspace _config = { _env, "config" };
 	Genode::Constructible<Genode::Rom_connection> _update { };
 
+	Timer::Connection _timer { _env };
+
+	/*
+	 * In persistent mode the interpreter is initialized once and the
+	 * compiled scripts are kept across triggers and config updates.
+	 */
+	bool _persistent  = false;
+	bool _initialized = false;
+
+	Genode::Constructible<Code_cache> _code_cache { };
+
+	Genode::Constructible<Genode::Reporter> _reporter { };
+
+	struct Stats
+	{
+		unsigned long runs = 0;
+		uint64_t      last_us = 0;
+		uint64_t      max_us  = 0;
+		uint64_t      sum_us  = 0;
+		uint64_t      compile_us = 0;  /* of the last cache miss */
+	} _stats { };
+
+	uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+	/**
+	 * Load the code object from precompiled bytecode
+	 *
+	 * The ROM contains a '.pyc' file as written by 'py_compile'. Its header
+	 * is checked against the magic number of the interpreter and the size
+	 * of the source.
+	 *
+	 * \return new reference or nullptr
+	 */
+	PyObject *_load_bytecode(char const *rom_name, size_t source_size)
+	{
+		enum { PYC_HEADER_SIZE = 12 };
+
+		try {
+			Genode::Attached_rom_dataspace rom(_env, rom_name);
+
+			unsigned char const *pyc = rom.local_addr<unsigned char const>();
+			if (rom.size() < PYC_HEADER_SIZE)
+				return nullptr;
+
+			auto le32 = [&] (unsigned offset) {
+				return (unsigned long)pyc[offset]
+				     | (unsigned long)pyc[offset + 1] << 8
+				     | (unsigned long)pyc[offset + 2] << 16
+				     | (unsigned long)pyc[offset + 3] << 24; };
+
+			if (le32(0) != (unsigned long)PyImport_GetMagicNumber()
+			 || le32(8) != (source_size & 0xffffffffUL)) {
+				Genode::warning("bytecode '", rom_name, "' does not match "
+				                "interpreter or source, compiling");
+				return nullptr;
+			}
+
+			PyObject *code = PyMarshal_ReadObjectFromString(
+				(char const *)pyc + PYC_HEADER_SIZE,
+				rom.size() - PYC_HEADER_SIZE);
+
+			if (code && !PyCode_Check(code)) {
+				Py_DECREF(code);
+				code = nullptr;
+			}
+			if (!code) PyErr_Clear();
+			return code;
+		}
+		catch (...) {
+			Genode::warning("bytecode ROM '", rom_name, "' not available");
+			return nullptr;
+		}
+	}
+
+	/**
+	 * Execute script with a cached code object
+	 */
+	int _execute_cached(Genode::Xml_node script, char const *filename)
+	{
+		FILE *fp = fopen(filename, "r");
+		if (!fp) {
+			Genode::error("failed to open '", Genode::Cstring(filename), "'");
+			return -1;
+		}
+
+		fseek(fp, 0, SEEK_END);
+		long const len = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+
+		size_t const size = len > 0 ? len : 0;
+		char *source = (char *)_heap.alloc(size + 1);
+		size_t const n = fread(source, 1, size, fp);
+		source[n] = 0;
+		fclose(fp);
+
+		uint64_t const hash = Code_cache::hash(source, n);
+
+		PyObject *code = _code_cache->lookup(hash, n);
+		if (!code) {
+			uint64_t const start_us = _now_us();
+
+			typedef Genode::String<128> Rom_name;
+			Rom_name const bytecode = script.attribute_value("bytecode", Rom_name());
+			if (bytecode.valid())
+				code = _load_bytecode(bytecode.string(), n);
+
+			if (!code)
+				code = Py_CompileString(source, filename, Py_file_input);
+
+			_stats.compile_us = _now_us() - start_us;
+
+			if (code)
+				_code_cache->insert(hash, n, code);
+		}
+
+		_heap.free(source, size + 1);
+
+		if (!code) {
+			PyErr_Print();
+			return -1;
+		}
+
+		PyObject *module  = PyImport_AddModule("__main__");
+		PyObject *globals = module ? PyModule_GetDict(module) : nullptr;
+		if (!globals)
+			return -1;
+
+		PyObject *file = PyUnicode_DecodeFSDefault(filename);
+		if (file) {
+			PyDict_SetItemString(globals, "__file__", file);
+			Py_DECREF(file);
+		}
+
+		PyObject *result = PyEval_EvalCode(code, globals, globals);
+		if (!result) {
+			PyErr_Print();
+			return -1;
+		}
+		Py_DECREF(result);
+		return 0;
+	}
 
-	int _execute()
+	/**
+	 * \param start_us  time of the trigger, for the latency report
+	 */
+	int _execute(uint64_t start_us)
 	{
 		enum {
 			MAX_NAME_LEN = 128
@@ -48,22 +292,59 @@ struct Python::Main
 		Genode::Xml_node script = _config.xml().sub_node("file");
 		script.attribute("name").value(filename, sizeof(filename));
 
-		FILE * fp = fopen(filename, "r");
+		int res = -1;
+		if (_persistent) {
+			res = _execute_cached(script, filename);
+		} else {
+			FILE * fp = fopen(filename, "r");
 
-		Genode::log("Starting python ...");
-		int res = PyRun_SimpleFile(fp, filename);
+			Genode::log("Starting python ...");
+			res = PyRun_SimpleFile(fp, filename);
+
+			fclose(fp);
+		}
 		Genode::log("Executed '", Genode::Cstring(filename), "'");
 
-		fclose(fp);
+		_record(_now_us() - start_us);
 		return res;
 	}
 
+	void _record(uint64_t us)
+	{
+		++_stats.runs;
+		_stats.last_us  = us;
+		_stats.sum_us  += us;
+		if (us > _stats.max_us) _stats.max_us = us;
+
+		if (!_reporter.constructed())
+			return;
+
+		_reporter->generate([&] (Genode::Xml_generator &xml) {
+			xml.attribute("runs", _stats.runs);
+			xml.node("latency", [&] () {
+				xml.attribute("last_us", _stats.last_us);
+				xml.attribute("avg_us",  _stats.sum_us / _stats.runs);
+				xml.attribute("max_us",  _stats.max_us);
+			});
+			if (_code_cache.constructed()) {
+				xml.node("code_cache", [&] () {
+					xml.attribute("hits",       _code_cache->hits);
+					xml.attribute("misses",     _code_cache->misses);
+					xml.attribute("compile_us", _stats.compile_us);
+				});
+			}
+		});
+	}
+
 	void _initialize()
 	{
 		enum {
 			MAX_NAME_LEN = 128
 		};
 
+		if (_initialized)
+			return;
+
 		wchar_t wbuf[MAX_NAME_LEN];
 
 		if (_config.xml().has_sub_node("pythonpath")) {
@@ -84,15 +365,40 @@ struct Python::Main
 		//don't support interactive mode, yet
 		Py_InteractiveFlag = 0;
 		Py_Initialize();
+
+		_initialized = true;
+
+		if (_persistent)
+			_code_cache.construct(_heap,
+				_config.xml().attribute_value("code_cache", 8U));
 	}
 
 	void _finalize()
 	{
+		/* a persistent interpreter lives as long as the component */
+		if (_persistent)
+			return;
+
 		Py_Finalize();
+		_initialized = false;
 	}
 
 	void _handle_config()
 	{
+		_config.update();
+
+		/* the mode is fixed once the interpreter is up */
+		if (!_initialized)
+			_persistent = _config.xml().attribute_value("persistent", false);
+
+		bool const report = _config.xml().attribute_value("report", false);
+		if (report && !_reporter.constructed()) {
+			_reporter.construct(_env, "python_stats");
+			_reporter->enabled(true);
+		}
+		if (!report)
+			_reporter.destruct();
+
 		_initialize();
 
 		if (_config.xml().has_sub_node("file")) {
@@ -105,12 +411,12 @@ struct Python::Main
 				_update->sigh(_trigger_handler);
 
 				if (_update->dataspace().valid())
-					_execute();
+					_execute(_now_us());
 
 				return;
 			}
 			else {
-				_execute();
+				_execute(_now_us());
 			}
 		}
 		else {
@@ -121,13 +427,19 @@ struct Python::Main
 		_finalize();
 	}
 
+	void _handle_config_update()
+	{
+		Libc::with_libc([&] () { _handle_config(); });
+	}
+
 	void _handle_trigger()
 	{
-		Libc::with_libc([&] () { _execute(); });
+		uint64_t const start_us = _now_us();
+		Libc::with_libc([&] () { _execute(start_us); });
 	}
 
 	Genode::Signal_handler<Main> _config_handler {
-		_env.ep(), *this, &Main::_handle_config };
+		_env.ep(), *this, &Main::_handle_config_update };
 
 	Genode::Signal_handler<Main> _trigger_handler {
 		_env.ep(), *this, &Main::_handle_trigger };
@@ -0,0 +1,145 @@
+/*
+ * \brief   Framebuffer session component
+ * \author  agent
+ * \date    2026-10-19
+ *
+ * The component hands out the dataspace of the Nitpicker framebuffer
+ * unmodified, so avplay renders directly into the buffer that Nitpicker
+ * composites into the Qt window. Refresh requests are merged and passed
+ * on with the next sync signal of the Nitpicker framebuffer, which is
+ * also forwarded to avplay to pace its frame output.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _FRAMEBUFFER_SESSION_COMPONENT_H_
+#define _FRAMEBUFFER_SESSION_COMPONENT_H_
+
+/* Genode includes */
+#include <base/attached_rom_dataspace.h>
+#include <base/rpc_server.h>
+#include <framebuffer_session/client.h>
+#include <os/reporter.h>
+#include <util/geometry.h>
+#include <util/reconstructible.h>
+
+
+namespace Framebuffer {
+	using namespace Genode;
+	struct Session_component;
+}
+
+
+struct Framebuffer::Session_component : Rpc_object<Framebuffer::Session>
+{
+	Env          &_env;
+	Entrypoint   &_ep;
+
+	Session_client _framebuffer;
+
+	typedef Genode::Rect<>  Rect;
+	typedef Genode::Point<> Point;
+	typedef Genode::Area<>  Area;
+
+	/* area refreshed by avplay since the last sync */
+	Rect _dirty { };
+
+	/* refresh requests since the last sync */
+	unsigned _pending = 0;
+
+	Signal_context_capability _client_sync_sigh { };
+
+	struct Stats
+	{
+		unsigned long displayed = 0;
+		unsigned long dropped   = 0;  /* overwritten before being shown */
+		unsigned long syncs     = 0;
+	} _stats { };
+
+	/* report about once per second at 50 Hz sync rate */
+	enum { REPORT_SYNCS = 50 };
+
+	Constructible<Expanding_reporter> _reporter { };
+
+	void _report()
+	{
+		_reporter->generate([&] (Xml_generator &xml) {
+			xml.attribute("displayed", _stats.displayed);
+			xml.attribute("dropped",   _stats.dropped);
+			xml.attribute("syncs",     _stats.syncs);
+		});
+	}
+
+	void _handle_sync()
+	{
+		++_stats.syncs;
+
+		if (_pending) {
+			_framebuffer.refresh(_dirty.x1(), _dirty.y1(),
+			                     _dirty.w(),  _dirty.h());
+			++_stats.displayed;
+			_stats.dropped += _pending - 1;
+			_pending = 0;
+			_dirty   = Rect();
+		}
+
+		/* let avplay produce the next frame */
+		if (_client_sync_sigh.valid())
+			Signal_transmitter(_client_sync_sigh).submit();
+
+		if (_reporter.constructed() && _stats.syncs % REPORT_SYNCS == 0)
+			_report();
+	}
+
+	Signal_handler<Session_component> _sync_handler {
+		_ep, *this, &Session_component::_handle_sync };
+
+	Session_component(Env &env, Entrypoint &ep,
+	                  Capability<Framebuffer::Session> framebuffer)
+	:
+		_env(env), _ep(ep), _framebuffer(framebuffer)
+	{
+		try {
+			Attached_rom_dataspace config(_env, "config");
+			if (config.xml().sub_node("report").attribute_value("frames", false))
+				_reporter.construct(_env, "frames", "frames");
+		} catch (...) { }
+
+		_framebuffer.sync_sigh(_sync_handler);
+		_ep.manage(*this);
+	}
+
+	~Session_component() { _ep.dissolve(*this); }
+
+
+	/***********************************
+	 ** Framebuffer session interface **
+	 ***********************************/
+
+	Dataspace_capability dataspace() override {
+		return _framebuffer.dataspace(); }
+
+	Mode mode() const override {
+		return _framebuffer.mode(); }
+
+	void mode_sigh(Signal_context_capability sigh) override {
+		_framebuffer.mode_sigh(sigh); }
+
+	void refresh(int x, int y, int w, int h) override
+	{
+		Rect const rect(Point(x, y), Area(w, h));
+
+		_dirty = _dirty.valid() ? Rect::compound(_dirty, rect) : rect;
+		++_pending;
+	}
+
+	void sync_sigh(Signal_context_capability sigh) override {
+		_client_sync_sigh = sigh; }
+};
+
+#endif /* _FRAMEBUFFER_SESSION_COMPONENT_H_ */
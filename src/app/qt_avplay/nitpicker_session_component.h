@@ -21,6 +21,9 @@
 #include <qnitpickerplatformwindow.h>
 #include <qnitpickerviewwidget/qnitpickerviewwidget.h>
 
+/* local includes */
+#include "framebuffer_session_component.h"
+
 
 namespace Nitpicker {
 	using namespace Genode;
@@ -38,6 +41,9 @@ struct Nitpicker::Session_component : Rpc_object<Nitpicker::Session>
 
 	Input::Session_component _input_component { _env, _env.ram() };
 
+	Framebuffer::Session_component _framebuffer_component {
+		_env, _ep, _connection.framebuffer_session() };
+
 	typedef Nitpicker::Session::Command_buffer Command_buffer;
 	Attached_ram_dataspace _command_ds;
 	Command_buffer &_command_buffer = *_command_ds.local_addr<Command_buffer>();
@@ -90,7 +96,7 @@ struct Nitpicker::Session_component : Rpc_object<Nitpicker::Session>
 	}
 
 	Framebuffer::Session_capability framebuffer_session() override {
-		return _connection.framebuffer_session(); }
+		return _framebuffer_component.cap(); }
 
 	Input::Session_capability input_session() override {
 		return _input_component.cap(); }
@@ -18,6 +18,7 @@
 #include <os/static_root.h>
 #include <base/attached_ram_dataspace.h>
 #include <base/component.h>
+#include <world/pcm_convert.h>
 
 
 namespace Raw_audio {
@@ -128,10 +129,8 @@ void Raw_audio::Sink::submit_audio()
 		auto *content = (float const *)_pcm.read_addr();
 
 		/* copy channel contents into sessions */
-		for (unsigned i = 0; i < STEREO_PERIOD; i += NUM_CHANNELS) {
-			for_each_channel([&] (int const c) {
-				p[c]->content()[i/NUM_CHANNELS] = content[i+c]; });
-		}
+		Pcm::f32_to_planar(p[LEFT]->content(), p[RIGHT]->content(),
+		                   content, Audio_out::PERIOD);
 
 		for_each_channel([&] (int const c) {
 			 _out[c]->submit(p[c]); });
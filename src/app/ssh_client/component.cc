@@ -19,6 +19,9 @@
 #include <libc/component.h>
 #include <util/xml_generator.h>
 #include <base/sleep.h>
+#include <base/heap.h>
+#include <os/reporter.h>
+#include <timer_session/connection.h>
 
 /* Libssh includes */
 #include <libssh/libssh.h>
@@ -31,6 +34,7 @@
 
 namespace Ssh_client {
 	using namespace Genode;
+	struct Buffer;
 	struct Main;
 
 	typedef Genode::String<64> String;
@@ -41,12 +45,78 @@ namespace Ssh_client {
 }
 
 
+struct Ssh_client::Buffer
+{
+	Allocator   &_alloc;
+	size_t const capacity;
+	char  *const data = (char *)_alloc.alloc(capacity);
+
+	size_t len    = 0; /* number of valid bytes */
+	size_t offset = 0; /* number of bytes already consumed */
+
+	Buffer(Allocator &alloc, size_t capacity)
+	: _alloc(alloc), capacity(capacity) { }
+
+	~Buffer() { _alloc.free(data, capacity); }
+
+	size_t pending() const { return len - offset; }
+
+	void reset() { len = offset = 0; }
+};
+
+
 struct Ssh_client::Main
 {
 	Libc::Env &_env;
 
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Timer::Connection _timer { _env };
+
 	Terminal::Connection _terminal { _env };
 
+	/*
+	 * Default size of SSH writes, it leaves room for the packet and MAC
+	 * overhead within a common Ethernet MTU
+	 */
+	enum { DEFAULT_BUFFER_SIZE = 16*1024, DEFAULT_WRITE_SIZE = 1400 };
+
+	/* channel to terminal, and terminal to channel data */
+	Constructible<Buffer> _rx { };
+	Constructible<Buffer> _tx { };
+
+	size_t _write_size = DEFAULT_WRITE_SIZE;
+
+	struct Stats
+	{
+		unsigned long long rx_bytes        = 0;
+		unsigned long long tx_bytes        = 0;
+		unsigned long      ssh_writes      = 0;
+		unsigned long      terminal_writes = 0;
+		unsigned long      stalls          = 0;
+	} _stats { };
+
+	/* counters at the time of the previous report */
+	Stats _reported { };
+
+	Reporter _reporter { _env, "ssh_stats" };
+
+	unsigned _report_ms = 0;
+
+	/*
+	 * Retry interval for forwarding data to a congested terminal
+	 */
+	enum { STALL_RETRY_US = 10*1000 };
+
+	void _handle_retry(Duration) { _handle_channel(1); }
+
+	Timer::One_shot_timeout<Main> _retry_timeout {
+		_timer, *this, &Main::_handle_retry };
+
+	void _handle_report(Duration);
+
+	Constructible<Timer::Periodic_timeout<Main>> _report_timeout { };
+
 	Genode::Signal_handler<Main> _terminal_handler {
 		_env.ep(), *this, &Main::_handle_terminal };
 
@@ -87,15 +157,79 @@ struct Ssh_client::Main
 		_exit(~0);
 	}
 
-	void _handle_terminal()
+	/**
+	 * Write buffered terminal input to the channel in chunks of the
+	 * configured write size
+	 *
+	 * \return  false if the channel did not take all data, the rest is
+	 *          written on the next channel event
+	 */
+	bool _flush_to_channel()
 	{
-		Libc::with_libc([&] () {
-			while (_terminal.avail()) {
-				char buf[256];
-				size_t n = _terminal.read(buf, sizeof(buf));
-				ssh_channel_write(_channel, buf, n);
+		Buffer &tx = *_tx;
+
+		while (tx.pending()) {
+			uint32_t const n = min(tx.pending(), _write_size);
+
+			int const written = ssh_channel_write(_channel, tx.data + tx.offset, n);
+			if (written < 0) _die();
+
+			/* the remote window is exhausted */
+			if (written == 0) return false;
+
+			_stats.ssh_writes++;
+			_stats.tx_bytes += written;
+			tx.offset       += written;
+		}
+		tx.reset();
+		return true;
+	}
+
+	/**
+	 * Write buffered channel output to the terminal
+	 *
+	 * \return  false if the terminal did not take all data
+	 */
+	bool _flush_to_terminal()
+	{
+		Buffer &rx = *_rx;
+
+		while (rx.pending()) {
+			size_t const n = _terminal.write(rx.data + rx.offset, rx.pending());
+			_stats.terminal_writes++;
+
+			if (n == 0) {
+				_stats.stalls++;
+				return false;
 			}
-		});
+			rx.offset += n;
+		}
+		rx.reset();
+		return true;
+	}
+
+	void _read_terminal()
+	{
+		Buffer &tx = *_tx;
+
+		/* coalesce all available input into as few writes as possible */
+		while (_terminal.avail()) {
+
+			/* continued on the next channel event */
+			if (tx.len == tx.capacity && !_flush_to_channel())
+				return;
+
+			size_t const n = _terminal.read(tx.data + tx.len,
+			                                tx.capacity - tx.len);
+			if (!n) break;
+			tx.len += n;
+		}
+		_flush_to_channel();
+	}
+
+	void _handle_terminal()
+	{
+		Libc::with_libc([&] () { _read_terminal(); });
 	}
 
 	void _handle_size()
@@ -116,19 +250,38 @@ struct Ssh_client::Main
 	void _handle_channel(int nready)
 	{
 		Libc::with_libc([&] () {
-			char buffer[256];
+			Buffer &rx = *_rx;
 
 			fd_set readfds;
 			fd_set noop;
 
+			/* resume input the channel did not take before */
+			if (_tx->pending()) _read_terminal();
+
+			/*
+			 * Stop reading from the channel while the terminal is congested.
+			 * The SSH flow control then throttles the remote side.
+			 */
+			if (!_flush_to_terminal()) {
+				_retry_timeout.schedule(Microseconds(STALL_RETRY_US));
+				return;
+			}
+
 			if (ssh_channel_is_eof(_channel)) _exit(0);
 
 			while (nready) {
 				while (true) {
-					int n = ssh_channel_read_nonblocking(_channel, buffer, sizeof(buffer), 0);
+					int n = ssh_channel_read_nonblocking(_channel, rx.data, rx.capacity, 0);
 					if (!n) break;
 					if (n < 0) _die();
-					_terminal.write(buffer, n);
+
+					_stats.rx_bytes += n;
+					rx.len = n;
+
+					if (!_flush_to_terminal()) {
+						_retry_timeout.schedule(Microseconds(STALL_RETRY_US));
+						return;
+					}
 				}
 
 				FD_ZERO(&noop);
@@ -167,8 +320,27 @@ struct Ssh_client::Main
 			int verbosity = config.attribute_value("verbose", false)
 				? SSH_LOG_FUNCTIONS : SSH_LOG_NOLOG;
 			ssh_options_set(_session, SSH_OPTIONS_LOG_VERBOSITY, &verbosity);
+
+			size_t const buffer_size = max((size_t)1024,
+				(size_t)config.attribute_value("buffer",
+					Number_of_bytes(DEFAULT_BUFFER_SIZE)));
+
+			_write_size = max((size_t)64, min(buffer_size,
+				(size_t)config.attribute_value("write_size",
+					Number_of_bytes(DEFAULT_WRITE_SIZE))));
+
+			_rx.construct(_heap, buffer_size);
+			_tx.construct(_heap, buffer_size);
+
+			_report_ms = config.attribute_value("report_ms", 0U);
 		});
 
+		if (_report_ms) {
+			_reporter.enabled(true);
+			_report_timeout.construct(_timer, *this, &Main::_handle_report,
+			                          Microseconds(_report_ms*1000UL));
+		}
+
 		/* read all files from the root directory */
 		ssh_options_set(_session, SSH_OPTIONS_SSH_DIR, "/");
 		ssh_options_set(_session, SSH_OPTIONS_KNOWNHOSTS, "/known_hosts");
@@ -314,6 +486,26 @@ struct Ssh_client::Main
 };
 
 
+void Ssh_client::Main::_handle_report(Duration)
+{
+	/* throughput in bytes per second over the last period */
+	auto rate = [&] (unsigned long long now, unsigned long long before) {
+		return ((now - before)*1000) / _report_ms; };
+
+	Reporter::Xml_generator xml(_reporter, [&] () {
+		xml.attribute("rx_bytes",        _stats.rx_bytes);
+		xml.attribute("tx_bytes",        _stats.tx_bytes);
+		xml.attribute("rx_rate",         rate(_stats.rx_bytes, _reported.rx_bytes));
+		xml.attribute("tx_rate",         rate(_stats.tx_bytes, _reported.tx_bytes));
+		xml.attribute("ssh_writes",      _stats.ssh_writes);
+		xml.attribute("terminal_writes", _stats.terminal_writes);
+		xml.attribute("stalls",          _stats.stalls);
+	});
+
+	_reported = _stats;
+}
+
+
 static void log_callback(int priority,
                          const char *function,
                          const char *buffer,
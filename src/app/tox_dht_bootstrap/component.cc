@@ -37,6 +37,11 @@ extern "C" {
 #include <os/reporter.h>
 #include <timer_session/connection.h>
 #include <libc/component.h>
+#include <libc/select.h>
+
+/* libc includes */
+#include <sys/socket.h>
+#include <netinet/in.h>
 
 
 namespace Tox_dht_bootstrap {
@@ -139,7 +144,7 @@ struct Tox_dht_bootstrap::Main
 
 	Libc::Env &_env;
 
-	Timer::Connection _timer { _env, "periodic-timeout" };
+	Timer::Connection _timer { _env, "dht-maintenance" };
 
 	Genode::Expanding_reporter _reporter { _env, "dht_state", "dht_state" };
 
@@ -151,6 +156,35 @@ struct Tox_dht_bootstrap::Main
 
 	int is_waiting_for_dht_connection = 1;
 
+	/*
+	 * Inbound packets are answered from 'networking_poll' as soon as the
+	 * socket becomes readable, the timer only drives 'do_dht' for the
+	 * ping and node-refresh deadlines of the DHT.
+	 */
+	enum { MAINTENANCE_US = 1000*1000 };
+
+	struct Stats
+	{
+		uint64_t rx_events   = 0; /* socket readiness notifications */
+		uint64_t polls       = 0; /* passes over the socket receive queue */
+		uint64_t maintenance = 0; /* 'do_dht' rounds */
+
+		/* time from readiness to the end of the poll pass */
+		uint64_t latency_sum_us = 0;
+		uint64_t latency_max_us = 0;
+
+		void record(uint64_t us)
+		{
+			++polls;
+			latency_sum_us += us;
+			if (us > latency_max_us) latency_max_us = us;
+		}
+	} _stats { };
+
+	/* statistics of the previous report, for the rates */
+	Stats    _reported    { };
+	uint64_t _reported_us = 0;
+
 	DHT *init_dht()
 	{
 		/* Initialize networking -
@@ -174,6 +208,60 @@ struct Tox_dht_bootstrap::Main
 
 		lan_discovery_init(dht);
 
+		return dht;
+	}
+
+	DHT *_dht = init_dht();
+
+	/**
+	 * Look up the descriptor of the UDP socket bound by toxcore
+	 *
+	 * The networking core does not expose its socket, so find the
+	 * datagram socket that is bound to our port.
+	 */
+	int _find_socket()
+	{
+		uint16_t const port = net_port(dht_get_net(_dht));
+
+		for (int fd = 0; fd < FD_SETSIZE; ++fd) {
+			int type = 0;
+			socklen_t type_len = sizeof(type);
+			if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &type_len) != 0
+			 || type != SOCK_DGRAM)
+				continue;
+
+			sockaddr_storage addr { };
+			socklen_t addr_len = sizeof(addr);
+			if (getsockname(fd, (sockaddr *)&addr, &addr_len) != 0)
+				continue;
+
+			if (addr.ss_family == AF_INET
+			 && ((sockaddr_in const &)addr).sin_port == port)
+				return fd;
+			if (addr.ss_family == AF_INET6
+			 && ((sockaddr_in6 const &)addr).sin6_port == port)
+				return fd;
+		}
+		return -1;
+	}
+
+	int const _socket = _find_socket();
+
+	Libc::Select_handler<Main> _select_handler {
+		*this, &Main::_select_ready };
+
+	Timer::Periodic_timeout<Main> _periodic_timeout {
+		_timer, *this, &Main::run, Genode::Microseconds(MAINTENANCE_US) };
+
+	Genode::Constructible<Timer::Periodic_timeout<Main>> _report_timeout { };
+
+	uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+	Main(Libc::Env &env) : _env(env)
+	{
+		if (_socket < 0)
+			Genode::warning("UDP socket not found, falling back to polling");
+
 		_env.config([&] (Genode::Xml_node const &config) {
 			config.for_each_sub_node("report", [&] (Genode::Xml_node const &node) {
 				if (node.attribute_value("dht", false)) {
@@ -182,18 +270,20 @@ struct Tox_dht_bootstrap::Main
 			});
 		});
 
-		return dht;
+		_reported_us = _now_us();
+		_poll(_reported_us);
 	}
 
-	DHT *_dht = init_dht();
-
-	Timer::Periodic_timeout<Main> _periodic_timeout {
-		_timer, *this, &Main::run, Genode::Microseconds(1000*1000) };
-
-	Genode::Constructible<Timer::Periodic_timeout<Main>> _report_timeout { };
-
-	Main(Libc::Env &env) : _env(env) { }
+	/**
+	 * Drain the socket and wait for it to become readable again
+	 */
+	void _poll(uint64_t ready_us);
 
+	void _select_ready(int, fd_set const &, fd_set const &, fd_set const &)
+	{
+		++_stats.rx_events;
+		Libc::with_libc([&] () { _poll(_now_us()); });
+	}
 
 	void report(Genode::Duration);
 	void run(Genode::Duration);
@@ -212,11 +302,43 @@ struct Tox_dht_bootstrap::Main
 };
 
 
+void Tox_dht_bootstrap::Main::_poll(uint64_t ready_us)
+{
+	for (;;) {
+		mono_time_update(_mono_time);
+		networking_poll(dht_get_net(_dht), nullptr);
+		_stats.record(_now_us() - ready_us);
+
+		if (_socket < 0)
+			return;
+
+		/* re-arm, or continue right away if more datagrams arrived */
+		fd_set readfds, noop;
+		FD_ZERO(&noop);
+		FD_ZERO(&readfds);
+		FD_SET(_socket, &readfds);
+
+		if (_select_handler.select(_socket+1, readfds, noop, noop) <= 0)
+			return;
+
+		++_stats.rx_events;
+		ready_us = _now_us();
+	}
+}
+
+
 void Tox_dht_bootstrap::Main::report(Genode::Duration)
 {
 	mono_time_update(_mono_time);
 
 	Libc::with_libc([&] () {
+		uint64_t const now_us     = _now_us();
+		uint64_t const elapsed_us = now_us - _reported_us;
+		uint64_t const polls      = _stats.polls - _reported.polls;
+
+		auto per_s = [&] (uint64_t count) {
+			return elapsed_us ? (count*1000*1000)/elapsed_us : 0; };
+
 		_reporter.generate([&] (Genode::Xml_generator &gen) {
 			uint64_t now = mono_time_get(_mono_time);
 			gen.attribute("timestamp", now);
@@ -225,6 +347,17 @@ void Tox_dht_bootstrap::Main::report(Genode::Duration)
 				//gen.attribute("secret", encode_key(dht_get_self_secret_key(_dht)));
 			});
 
+			gen.node("service", [&] () {
+				gen.attribute("rx_events", _stats.rx_events);
+				gen.attribute("polls", _stats.polls);
+				gen.attribute("maintenance", _stats.maintenance);
+				gen.attribute("rx_events_per_s", per_s(_stats.rx_events - _reported.rx_events));
+				gen.attribute("polls_per_s", per_s(polls));
+				gen.attribute("latency_avg_us", polls
+					? (_stats.latency_sum_us - _reported.latency_sum_us)/polls : 0);
+				gen.attribute("latency_max_us", _stats.latency_max_us);
+			});
+
 			for_each_close_peer([&] (Client_data const &peer) {
 				gen.node("close", [&] () {
 					gen.attribute("public", encode_key(peer.public_key));
@@ -238,6 +371,11 @@ void Tox_dht_bootstrap::Main::report(Genode::Duration)
 				});
 			});
 		});
+
+		/* the maximum covers one report interval */
+		_reported = _stats;
+		_reported_us = now_us;
+		_stats.latency_max_us = 0;
 	});
 }
 
@@ -253,13 +391,16 @@ void Tox_dht_bootstrap::Main::run(Genode::Duration)
 		}
 
 		do_dht(_dht);
+		++_stats.maintenance;
 
 		if (mono_time_is_timeout(_mono_time, last_LANdiscovery, is_waiting_for_dht_connection ? 5 : LAN_DISCOVERY_INTERVAL)) {
 			lan_discovery_send(net_htons(PORT), _dht);
 			last_LANdiscovery = mono_time_get(_mono_time);
 		}
 
-		networking_poll(dht_get_net(_dht), nullptr);
+		/* without readiness notifications, poll along with the maintenance */
+		if (_socket < 0)
+			_poll(_now_us());
 	});
 }
 
@@ -17,11 +17,13 @@
 #include <base/component.h>
 #include <base/log.h>
 #include <base/heap.h>
+#include <base/registry.h>
 #include <input/component.h>
 #include <input/keycodes.h>
 #include <input_session/connection.h>
 #include <os/reporter.h>
-#include <os/static_root.h>
+#include <os/session_policy.h>
+#include <root/root.h>
 #include <timer_session/connection.h>
 #include <usb/types.h>
 #include <usb_session/connection.h>
@@ -43,7 +45,6 @@
 
 static bool const verbose_intr = false;
 static bool const verbose      = false;
-static bool const debug        = false;
 static bool const dump_dt      = false;
 
 
@@ -51,7 +52,11 @@ namespace Usb {
 	using namespace Genode;
 
 	struct Hid;
+	struct Input_root;
 	struct Main;
+
+	typedef Registered<Hid> Registered_hid;
+	typedef Registry<Registered_hid> Hid_registry;
 }
 
 
@@ -61,11 +66,32 @@ namespace Usb {
 
 /**
  * USB HID
+ *
+ * Each instance drives one gamepad through its own Usb session and
+ * provides the events of this gamepad through its own Input session.
  */
 struct Usb::Hid
 {
-	Env                      &env;
-	Input::Session_component &input_session;
+	typedef String<32>  Name;
+	typedef String<64>  Label;
+
+	/*
+	 * Number of interrupt transfers kept queued at the host controller
+	 *
+	 * With more than one transfer in flight, the host controller polls
+	 * the endpoint at its bInterval while we process the previous report.
+	 */
+	enum { DEFAULT_URBS = 4 };
+
+	Env                     &env;
+	Timer::Connection       &timer;
+	Name              const  name;
+	unsigned          const  num_urbs;
+
+	Input::Session_component input_session { env, env.pd() };
+
+	Capability<Input::Session> const input_cap {
+		env.ep().manage(input_session) };
 
 	/*
 	 * Supported USB HID gamepads
@@ -95,26 +121,116 @@ struct Usb::Hid
 
 	Hid_device *device = &generic;
 
-	Timer::Connection timer { env };
+	/* true while interrupt transfers are (re-)submitted */
+	bool polling = false;
+
+	unsigned urbs_in_flight = 0;
+
+	/* set when a report was received, failed transfers are not replaced */
+	bool refill = false;
+
+	uint64_t now_us() { return timer.curr_time().trunc_to_plain_us().value; }
 
-	unsigned polling_us = 0;
+	/**
+	 * Report statistics
+	 */
+	struct Stats
+	{
+		uint64_t reports = 0;
+		uint64_t errors  = 0;
+
+		/* time between two consecutive reports */
+		uint64_t last_report_us  = 0;
+		uint64_t interval_sum_us = 0;
+		uint64_t interval_max_us = 0;
+		uint64_t intervals       = 0;
+
+		/*
+		 * Time from submitting a transfer until its completion is handled,
+		 * which includes the time the transfer stays queued
+		 */
+		uint64_t pending_sum_us = 0;
+		uint64_t pending_max_us = 0;
+
+		/* time spent translating a report into input events */
+		uint64_t parse_sum_us = 0;
+		uint64_t parse_max_us = 0;
+
+		/* reports since the last generated report */
+		uint64_t window_reports = 0;
+
+		static void _update(uint64_t &sum, uint64_t &max, uint64_t value)
+		{
+			sum += value;
+			if (value > max) max = value;
+		}
+
+		void report(uint64_t submitted_us, uint64_t received_us, uint64_t parsed_us)
+		{
+			if (last_report_us) {
+				_update(interval_sum_us, interval_max_us, received_us - last_report_us);
+				++intervals;
+			}
+			last_report_us = received_us;
+
+			_update(pending_sum_us, pending_max_us, received_us - submitted_us);
+			_update(parse_sum_us,   parse_max_us,   parsed_us - received_us);
+
+			++reports;
+			++window_reports;
+		}
+
+		void generate(Xml_generator &xml, uint64_t window_us)
+		{
+			xml.attribute("reports", reports);
+			xml.attribute("errors",  errors);
+			xml.attribute("rate_hz", window_us ? (window_reports*1000000)/window_us : 0);
+
+			xml.node("interval", [&] () {
+				xml.attribute("avg_us", intervals ? interval_sum_us/intervals : 0);
+				xml.attribute("max_us", interval_max_us); });
+
+			xml.node("pending", [&] () {
+				xml.attribute("avg_us", reports ? pending_sum_us/reports : 0);
+				xml.attribute("max_us", pending_max_us); });
+
+			xml.node("parse", [&] () {
+				xml.attribute("avg_us", reports ? parse_sum_us/reports : 0);
+				xml.attribute("max_us", parse_max_us); });
+
+			window_reports = 0;
+		}
+	};
+
+	Stats stats { };
+
+	void generate_report(Xml_generator &xml, uint64_t window_us)
+	{
+		xml.node("device", [&] () {
+			xml.attribute("name",   name);
+			xml.attribute("driver", device->name);
+			xml.attribute("urbs",   urbs_in_flight);
+			stats.generate(xml, window_us);
+		});
+	}
 
 	void state_change()
 	{
 		if (usb.plugged()) {
-			log("Gamepad plugged in");
+			log(name, ": gamepad plugged in");
 			probe_device();
 			return;
 		}
 
-		log("Gamepad unplugged");
+		polling = false;
+		log(name, ": gamepad unplugged");
 	}
 
 	/* construct before Usb::Connection so the dispatcher is valid */
 	Signal_handler<Hid> state_dispatcher { env.ep(), *this, &Hid::state_change };
 
 	Allocator_avl    usb_alloc;
-	Usb::Connection  usb { env, &usb_alloc, "usb_gamepad", 32*1024, state_dispatcher };
+	Usb::Connection  usb;
 
 	Usb::Config_descriptor    config_descr;
 	Usb::Device_descriptor    device_descr;
@@ -197,13 +313,16 @@ struct Usb::Hid
 		}
 
 		/* kick-off polling */
-		timer.trigger_once(polling_us);
+		polling = true;
+		submit_urbs();
 	}
 
-	void handle_irq_packet(Packet_descriptor &p)
+	void handle_irq_packet(Packet_descriptor &p, uint64_t submitted_us)
 	{
 		if (!p.read_transfer()) { return; }
 
+		uint64_t const received_us = now_us();
+
 		uint8_t const * const data = (uint8_t*)usb.source()->packet_content(p);
 		size_t           const len = p.transfer.actual_size > 0
 		                           ? p.transfer.actual_size : 0;
@@ -213,11 +332,12 @@ struct Usb::Hid
 		}
 		catch (...) {
 			error("input data is invalid, reconnect device");
+			polling = false;
 			return;
 		}
 
-		/* keep on r^Wpolling */
-		if (polling_us) { timer.trigger_once(polling_us); }
+		stats.report(submitted_us, received_us, now_us());
+		refill = true;
 	}
 
 	struct String_descr
@@ -281,6 +401,10 @@ struct Usb::Hid
 		enum State { VALID, FREE, CANCELED };
 		State state = FREE;
 
+		/* packet is one of the queued interrupt transfers */
+		bool     urb          = false;
+		uint64_t submitted_us = 0;
+
 		void complete(Usb::Packet_descriptor &p) override { }
 
 		void complete(Usb::Hid &hid, Usb::Packet_descriptor &p)
@@ -288,6 +412,11 @@ struct Usb::Hid
 			if (state != VALID)
 				return;
 
+			if (urb) {
+				hid.urbs_in_flight--;
+				if (!p.succeded) hid.stats.errors++;
+			}
+
 			if (!p.succeded) {
 				/*
 				 * We might end up here b/c the generic driver was used and a vendor
@@ -301,7 +430,7 @@ struct Usb::Hid
 			}
 
 			switch (p.type) {
-				case Usb::Packet_descriptor::IRQ:         hid.handle_irq_packet(p);    break;
+				case Usb::Packet_descriptor::IRQ:         hid.handle_irq_packet(p, submitted_us); break;
 				case Usb::Packet_descriptor::CTRL:        hid.handle_ctrl(p);          break;
 				case Usb::Packet_descriptor::STRING:      hid.handle_string_packet(p); break;
 				case Usb::Packet_descriptor::CONFIG:      hid.handle_config_packet(p); break;
@@ -320,6 +449,12 @@ struct Usb::Hid
 			dynamic_cast<Completion *>(p.completion)->complete(*this, p);
 			free_packet(p);
 		}
+
+		/* replace the completed interrupt transfers */
+		if (refill) {
+			refill = false;
+			submit_urbs();
+		}
 	}
 
 	Signal_handler<Hid> ack_avail_dispatcher { env.ep(), *this, &Hid::ack_avail };
@@ -391,10 +526,6 @@ struct Usb::Hid
 			return false;
 		}
 
-		polling_us = 1000 * ep_descr.polling_interval;
-
-		if (debug) { polling_us = 1000 * 1000; }
-
 		/*
 		 * Request HID report descriptor here because certain devices,
 		 * e.g., XBox 360 controller, will not respond otherwise.
@@ -470,26 +601,44 @@ struct Usb::Hid
 		return true;
 	}
 
-	void handle_polling()
+	/**
+	 * Keep 'num_urbs' interrupt transfers queued at the USB driver
+	 */
+	void submit_urbs()
 	{
-		Usb::Packet_descriptor p = alloc_packet(ep_descr.max_packet_size);
+		enum { DEFAULT_POLLING_INTERVAL = 10 };
 
-		p.type                      = Usb::Packet_descriptor::IRQ;
-		p.succeded                  = false;
-		p.transfer.ep               = ep_descr.address;
-		p.transfer.polling_interval = 10;
+		int const interval = ep_descr.polling_interval
+		                   ? ep_descr.polling_interval
+		                   : (int)DEFAULT_POLLING_INTERVAL;
 
-		usb.source()->submit_packet(p);
-	}
+		while (polling && urbs_in_flight < num_urbs) {
+
+			Usb::Packet_descriptor p;
+			try { p = alloc_packet(ep_descr.max_packet_size); }
+			catch (Queue_full)         { return; }
+			catch (No_completion_free) { return; }
 
-	Signal_handler<Hid> polling_dispatcher = {
-		env.ep(), *this, &Hid::handle_polling };
+			p.type                      = Usb::Packet_descriptor::IRQ;
+			p.succeded                  = false;
+			p.transfer.ep               = ep_descr.address;
+			p.transfer.polling_interval = interval;
+
+			Completion &c = *dynamic_cast<Completion *>(p.completion);
+			c.urb          = true;
+			c.submitted_us = now_us();
+
+			usb.source()->submit_packet(p);
+			urbs_in_flight++;
+		}
+	}
 
 	Completion *_alloc_completion()
 	{
 		for (unsigned i = 0; i < Usb::Session::TX_QUEUE_SIZE; i++)
 			if (completions[i].state == Completion::FREE) {
 				completions[i].state = Completion::VALID;
+				completions[i].urb   = false;
 				return &completions[i];
 			}
 
@@ -523,35 +672,140 @@ struct Usb::Hid
 	/**
 	 * Constructor
 	 *
-	 * \param env    environment
-	 * \param alloc  allocator used by Usb::Connection
-	 * \param input  Input session
+	 * \param env       environment
+	 * \param alloc     allocator used by Usb::Connection
+	 * \param timer     time source for the statistics
+	 * \param name      name used for Input session policies and reports
+	 * \param label     label of the Usb session
+	 * \param num_urbs  number of queued interrupt transfers
 	 */
-	Hid(Env &env, Genode::Allocator &alloc, Input::Session_component &input)
-	: env(env), input_session(input), usb_alloc(&alloc)
+	Hid(Env &env, Genode::Allocator &alloc, Timer::Connection &timer,
+	    Name const &name, Label const &label, unsigned num_urbs)
+	:
+		env(env), timer(timer), name(name),
+		num_urbs(max(1U, min(num_urbs, (unsigned)Usb::Session::TX_QUEUE_SIZE / 2))),
+		usb_alloc(&alloc),
+		usb(env, &usb_alloc, label.string(), 32*1024, state_dispatcher)
 	{
-		usb.tx_channel()->sigh_ack_avail(ack_avail_dispatcher);
+		input_session.event_queue().enabled(true);
 
-		timer.sigh(polling_dispatcher);
+		usb.tx_channel()->sigh_ack_avail(ack_avail_dispatcher);
 
 		/* HID gets initialized by state_change() */
 	}
 };
 
 
+/**
+ * Root handing out the Input session of the gamepad selected by policy
+ *
+ * If only one gamepad is configured, clients without a matching policy
+ * are connected to it.
+ */
+struct Usb::Input_root : Rpc_object<Typed_root<Input::Session>>
+{
+	Hid_registry           &_devices;
+	Attached_rom_dataspace &_config;
+
+	Input_root(Hid_registry &devices, Attached_rom_dataspace &config)
+	: _devices(devices), _config(config) { }
+
+	Session_capability session(Root::Session_args const &args,
+	                           Affinity const &) override
+	{
+		Session_label const label = label_from_args(args.string());
+
+		Hid::Name device_name { };
+		try {
+			Session_policy const policy(label, _config.xml());
+			device_name = policy.attribute_value("device", Hid::Name());
+		} catch (Session_policy::No_policy_defined) { }
+
+		Session_capability cap { };
+		unsigned           num_devices = 0;
+
+		_devices.for_each([&] (Hid &hid) {
+			++num_devices;
+			if (hid.name == device_name || !device_name.valid())
+				cap = hid.input_cap;
+		});
+
+		if (!cap.valid() || (!device_name.valid() && num_devices > 1)) {
+			error("no gamepad for session '", label, "'");
+			throw Service_denied();
+		}
+
+		return cap;
+	}
+
+	void upgrade(Session_capability, Root::Upgrade_args const &) override { }
+
+	void close(Session_capability) override { }
+};
+
+
 struct Usb::Main
 {
 	Env  &env;
 	Heap  heap { env.ram(), env.rm() };
 
-	Input::Session_component    input_session { env, env.pd() };
-	Static_root<Input::Session> input_root { env.ep().manage(input_session) };
+	Attached_rom_dataspace config { env, "config" };
+
+	Timer::Connection timer { env };
+
+	Hid_registry devices { };
+
+	Input_root input_root { devices, config };
 
-	Usb::Hid hid { env, heap, input_session };
+	Constructible<Reporter> reporter { };
+
+	Constructible<Timer::Periodic_timeout<Main>> report_timeout { };
+
+	uint64_t last_report_us = 0;
+
+	void handle_report(Duration now)
+	{
+		uint64_t const now_us    = now.trunc_to_plain_us().value;
+		uint64_t const window_us = now_us - last_report_us;
+		last_report_us = now_us;
+
+		Reporter::Xml_generator xml(*reporter, [&] () {
+			devices.for_each([&] (Hid &hid) {
+				hid.generate_report(xml, window_us); });
+		});
+	}
 
 	Main(Env &env) : env(env)
 	{
-		input_session.event_queue().enabled(true);
+		Xml_node const node = config.xml();
+
+		unsigned const urbs = node.attribute_value("urbs", (unsigned)Hid::DEFAULT_URBS);
+
+		/*
+		 * Each <device> node denotes one gamepad, the Usb session is
+		 * labeled with the 'label' attribute or, if absent, its name.
+		 */
+		node.for_each_sub_node("device", [&] (Xml_node const &device) {
+			Hid::Name  const name  = device.attribute_value("name", Hid::Name());
+			Hid::Label const label = device.attribute_value("label", Hid::Label(name.string()));
+
+			new (heap) Registered_hid(devices, env, heap, timer, name, label,
+			                          device.attribute_value("urbs", urbs));
+		});
+
+		/* default to one gamepad as before */
+		if (!node.has_sub_node("device"))
+			new (heap) Registered_hid(devices, env, heap, timer,
+			                          "gamepad", "usb_gamepad", urbs);
+
+		unsigned const report_ms = node.attribute_value("report_ms", 0U);
+		if (report_ms) {
+			reporter.construct(env, "gamepads");
+			reporter->enabled(true);
+			report_timeout.construct(timer, *this, &Main::handle_report,
+			                         Microseconds(report_ms*1000UL));
+		}
+
 		env.parent().announce(env.ep().manage(input_root));
 	}
 };
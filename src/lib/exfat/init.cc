@@ -15,6 +15,7 @@
 #include <base/log.h>
 
 #include <fuse_private.h>
+#include <fuse_block_cache.h>
 
 extern "C" {
 
@@ -57,7 +58,10 @@ void Fuse::deinit_fs(void)
 }
 
 
-void Fuse::sync_fs(void) { }
+void Fuse::sync_fs(void)
+{
+	Fuse::block_cache_sync();
+}
 
 
 bool Fuse::support_symlinks(void)
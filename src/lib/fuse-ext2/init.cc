@@ -17,6 +17,7 @@
 
 #include <fuse.h>
 #include <fuse_private.h>
+#include <fuse_block_cache.h>
 
 /* libc includes */
 #include <stdlib.h>
@@ -95,6 +96,7 @@ void Fuse::sync_fs(void)
 {
 	Genode::log("libc_fuse_ext2: sync file system...");
 	ext2fs_flush(e2fs);
+	Fuse::block_cache_sync();
 }
 
 
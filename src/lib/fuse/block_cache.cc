@@ -0,0 +1,570 @@
+/*
+ * \brief  Block cache beneath the FUSE file-system backends
+ * \author agent
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/lock.h>
+#include <base/log.h>
+#include <util/construct_at.h>
+#include <util/string.h>
+
+/* libc includes */
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+#include <fuse_block_cache.h>
+
+
+namespace Fuse { class Block_cache; }
+
+
+class Fuse::Block_cache
+{
+	public:
+
+		enum {
+			BLOCK_SIZE     = 4096,
+			SETS           = 128,
+			WAYS           = 4,
+			MAX_READ_AHEAD = 32,  /* blocks */
+			MAX_RUN        = 32,  /* blocks per coalesced write */
+		};
+
+	private:
+
+		struct Entry
+		{
+			off_t         block;
+			size_t        valid;     /* bytes, less at the end of the device */
+			bool          used;
+			bool          dirty;
+			unsigned long last_used;
+			char          data[BLOCK_SIZE];
+		};
+
+		int   const _fd;
+		off_t const _size;    /* of the device in bytes */
+
+		Entry *_entries;
+		char  *_bounce;     /* for read-ahead and coalesced writes */
+
+		off_t         _pos = 0;
+		off_t         _next_block = -1;   /* expected by a sequential reader */
+		unsigned      _window = 1;        /* read-ahead window in blocks */
+		unsigned long _clock = 0;
+		bool          _error = false;    /* last device request failed */
+
+		Block_cache_stats _stats { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+		Entry *_set(off_t block) { return &_entries[(block % SETS) * WAYS]; }
+
+		Entry *_lookup(off_t block)
+		{
+			Entry *set = _set(block);
+			for (unsigned i = 0; i < WAYS; i++)
+				if (set[i].used && set[i].block == block)
+					return &set[i];
+			return nullptr;
+		}
+
+		bool _write_entry(Entry &e)
+		{
+			++_stats.device_writes;
+			ssize_t const n = ::pwrite(_fd, e.data, e.valid, e.block*BLOCK_SIZE);
+			if (n != (ssize_t)e.valid) {
+				_error = true;
+				return false;
+			}
+
+			e.dirty = false;
+			--_stats.dirty;
+			++_stats.written;
+			return true;
+		}
+
+		/**
+		 * Return unused entry for 'block', evicting the least recently
+		 * used one of its set and preferring clean entries
+		 */
+		Entry *_alloc(off_t block)
+		{
+			Entry *set = _set(block);
+			Entry *victim = nullptr;
+
+			for (unsigned i = 0; i < WAYS; i++) {
+				Entry &e = set[i];
+				if (!e.used) { victim = &e; break; }
+
+				if (!victim
+				 || (victim->dirty && !e.dirty)
+				 || (victim->dirty == e.dirty && e.last_used < victim->last_used))
+					victim = &e;
+			}
+
+			if (victim->used && victim->dirty) {
+				++_stats.evictions;
+				if (!_write_entry(*victim))
+					return nullptr;
+			}
+
+			victim->block     = block;
+			victim->valid     = 0;
+			victim->used      = true;
+			victim->dirty     = false;
+			victim->last_used = ++_clock;
+			return victim;
+		}
+
+		/**
+		 * Read 'block' and, for sequential access, the blocks that follow
+		 */
+		Entry *_fetch(off_t block)
+		{
+			if (block == _next_block)
+				_window = Genode::min((unsigned)MAX_READ_AHEAD, _window*2);
+			else
+				_window = 1;
+
+			/* never overwrite blocks that are already cached */
+			unsigned count = 1;
+			while (count < _window && !_lookup(block + count))
+				++count;
+
+			++_stats.device_reads;
+			ssize_t const n = ::pread(_fd, _bounce, count*BLOCK_SIZE, block*BLOCK_SIZE);
+			if (n <= 0) {
+				/* a short read at the end of the device is no error */
+				_error = n < 0;
+				return nullptr;
+			}
+
+			Entry *first = nullptr;
+			for (unsigned i = 0; i < count && (ssize_t)(i*BLOCK_SIZE) < n; i++) {
+				Entry *e = _alloc(block + i);
+				if (!e) return first;
+
+				e->valid = Genode::min((size_t)BLOCK_SIZE, (size_t)n - i*BLOCK_SIZE);
+				Genode::memcpy(e->data, _bounce + i*BLOCK_SIZE, e->valid);
+
+				if (i == 0) first = e;
+				else        ++_stats.read_ahead;
+			}
+			return first;
+		}
+
+		static int _compare_block(void const *a, void const *b)
+		{
+			off_t const x = (*(Entry * const *)a)->block;
+			off_t const y = (*(Entry * const *)b)->block;
+			return x < y ? -1 : x > y;
+		}
+
+		/*
+		 * Noncopyable
+		 */
+		Block_cache(Block_cache const &);
+		Block_cache &operator = (Block_cache const &);
+
+	public:
+
+		Block_cache(int fd, off_t size)
+		:
+			_fd(fd), _size(size),
+			_entries((Entry *)calloc(SETS*WAYS, sizeof(Entry))),
+			_bounce((char *)malloc(MAX_READ_AHEAD*BLOCK_SIZE))
+		{ }
+
+		~Block_cache()
+		{
+			free(_bounce);
+			free(_entries);
+		}
+
+		bool valid() const { return _entries && _bounce; }
+
+		int fd() const { return _fd; }
+
+		Block_cache_stats const &stats() const { return _stats; }
+
+		/**
+		 * Result of a request, -1 only if nothing was transferred due to
+		 * a device error
+		 */
+		ssize_t _result(size_t done)
+		{
+			if (done || !_error) return done;
+
+			errno = EIO;
+			return -1;
+		}
+
+		ssize_t pread(char *buf, size_t count, off_t offset)
+		{
+			_error = false;
+
+			if (offset >= _size) return 0;
+			count = Genode::min(count, (size_t)(_size - offset));
+
+			size_t done = 0;
+			while (done < count) {
+				off_t  const pos   = offset + done;
+				off_t  const block = pos / BLOCK_SIZE;
+				size_t const skip  = pos % BLOCK_SIZE;
+
+				Entry *e = _lookup(block);
+				if (e) ++_stats.hits;
+				else {
+					++_stats.misses;
+					e = _fetch(block);
+				}
+				_next_block = block + 1;
+
+				if (!e || e->valid <= skip) break;
+
+				e->last_used = ++_clock;
+
+				size_t const n = Genode::min(count - done, e->valid - skip);
+				Genode::memcpy(buf + done, e->data + skip, n);
+				done += n;
+
+				/* end of device */
+				if (e->valid < BLOCK_SIZE) break;
+			}
+			return _result(done);
+		}
+
+		ssize_t pwrite(char const *buf, size_t count, off_t offset)
+		{
+			_error = false;
+
+			/* the device cannot grow */
+			if (offset >= _size) {
+				errno = ENOSPC;
+				return -1;
+			}
+			count = Genode::min(count, (size_t)(_size - offset));
+
+			size_t done = 0;
+			while (done < count) {
+				off_t  const pos   = offset + done;
+				off_t  const block = pos / BLOCK_SIZE;
+				size_t const skip  = pos % BLOCK_SIZE;
+				size_t const n     = Genode::min(count - done, (size_t)BLOCK_SIZE - skip);
+
+				Entry *e = _lookup(block);
+				if (!e) {
+					if (n == BLOCK_SIZE || (off_t)(pos + n) == _size) {
+						/* whole block, no need to read it first */
+						e = _alloc(block);
+						if (e) e->valid = n;
+					} else {
+						e = _fetch(block);
+					}
+				}
+				if (!e || e->valid < skip + n) break;
+
+				Genode::memcpy(e->data + skip, buf + done, n);
+				e->last_used = ++_clock;
+				if (!e->dirty) {
+					e->dirty = true;
+					++_stats.dirty;
+				}
+				done += n;
+			}
+			return _result(done);
+		}
+
+		/**
+		 * Write back dirty blocks in ascending order, consecutive blocks
+		 * with a single request
+		 */
+		bool flush()
+		{
+			if (!_stats.dirty)
+				return true;
+
+			Entry **dirty = (Entry **)malloc(_stats.dirty*sizeof(Entry *));
+			if (!dirty) {
+				/* fall back to writing blocks one by one */
+				bool ok = true;
+				for (unsigned i = 0; i < SETS*WAYS; i++)
+					if (_entries[i].dirty)
+						ok &= _write_entry(_entries[i]);
+				return ok;
+			}
+
+			unsigned num = 0;
+			for (unsigned i = 0; i < SETS*WAYS; i++)
+				if (_entries[i].dirty)
+					dirty[num++] = &_entries[i];
+
+			qsort(dirty, num, sizeof(Entry *), _compare_block);
+
+			bool ok = true;
+			for (unsigned i = 0; i < num; ) {
+
+				/* gather a run of consecutive full blocks */
+				unsigned run = 1;
+				while (i + run < num && run < MAX_RUN
+				    && dirty[i + run]->block == dirty[i]->block + run
+				    && dirty[i + run - 1]->valid == BLOCK_SIZE)
+					++run;
+
+				if (run == 1) {
+					ok &= _write_entry(*dirty[i]);
+					++i;
+					continue;
+				}
+
+				size_t len = 0;
+				for (unsigned j = 0; j < run; j++) {
+					Genode::memcpy(_bounce + len, dirty[i + j]->data, dirty[i + j]->valid);
+					len += dirty[i + j]->valid;
+				}
+
+				++_stats.device_writes;
+				if (::pwrite(_fd, _bounce, len, dirty[i]->block*BLOCK_SIZE) == (ssize_t)len) {
+					for (unsigned j = 0; j < run; j++)
+						dirty[i + j]->dirty = false;
+					_stats.dirty   -= run;
+					_stats.written += run;
+				} else {
+					ok = false;
+				}
+				i += run;
+			}
+
+			free(dirty);
+			return ok;
+		}
+
+		off_t lseek(off_t offset, int whence)
+		{
+			switch (whence) {
+			case SEEK_SET: _pos = offset; break;
+			case SEEK_CUR: _pos += offset; break;
+			case SEEK_END: _pos = _size + offset; break;
+			default:
+				errno = EINVAL;
+				return -1;
+			}
+			return _pos;
+		}
+
+		off_t pos() const { return _pos; }
+
+		void advance(ssize_t n) { if (n > 0) _pos += n; }
+};
+
+
+/*
+ * The backends open the block device once.
+ */
+static Fuse::Block_cache *_cache;
+static Genode::Lock       _cache_lock;
+
+static char const *BLOCK_DEVICE = "/dev/blkdev";
+
+
+static Fuse::Block_cache *cache_of(int fd)
+{
+	return (_cache && _cache->fd() == fd) ? _cache : nullptr;
+}
+
+
+static void destroy_cache()
+{
+	if (_cache) {
+		_cache->~Block_cache();
+		free(_cache);
+	}
+	_cache = nullptr;
+}
+
+
+static void log_stats(Fuse::Block_cache_stats const &s)
+{
+	Genode::log("libfuse: block cache hits=", s.hits, " misses=", s.misses,
+	            " read_ahead=", s.read_ahead,
+	            " device_reads=", s.device_reads,
+	            " device_writes=", s.device_writes,
+	            " written=", s.written, " evictions=", s.evictions);
+}
+
+
+void Fuse::block_cache_sync()
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (!_cache) return;
+
+	if (!_cache->flush())
+		Genode::error("libfuse: writing back block cache failed");
+	::fsync(_cache->fd());
+
+	log_stats(_cache->stats());
+}
+
+
+Fuse::Block_cache_stats Fuse::block_cache_stats()
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (_cache) return _cache->stats();
+
+	Block_cache_stats empty { 0, 0, 0, 0, 0, 0, 0, 0 };
+	return empty;
+}
+
+
+extern "C" {
+
+int fuse_block_open(const char *path, int flags, ...)
+{
+	mode_t mode = 0;
+	if (flags & O_CREAT) {
+		va_list ap;
+		va_start(ap, flags);
+		mode = (mode_t)va_arg(ap, int);
+		va_end(ap);
+	}
+
+	int const fd = ::open(path, flags, mode);
+	if (fd < 0 || Genode::strcmp(path, BLOCK_DEVICE) != 0)
+		return fd;
+
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (_cache)
+		return fd;
+
+	off_t const size = ::lseek(fd, 0, SEEK_END);
+	::lseek(fd, 0, SEEK_SET);
+	if (size <= 0) {
+		Genode::warning("libfuse: unknown size of ", BLOCK_DEVICE, ", block cache disabled");
+		return fd;
+	}
+
+	void *mem = malloc(sizeof(Fuse::Block_cache));
+	if (mem)
+		_cache = Genode::construct_at<Fuse::Block_cache>(mem, fd, size);
+
+	if (!_cache || !_cache->valid()) {
+		Genode::warning("libfuse: no memory for block cache, using device directly");
+		destroy_cache();
+	}
+	return fd;
+}
+
+
+int fuse_block_close(int fd)
+{
+	bool flushed = true;
+	{
+		Genode::Lock::Guard guard(_cache_lock);
+
+		if (Fuse::Block_cache *cache = cache_of(fd)) {
+			flushed = cache->flush();
+			if (!flushed)
+				Genode::error("libfuse: writing back block cache failed");
+			log_stats(cache->stats());
+			destroy_cache();
+		}
+	}
+
+	int const res = ::close(fd);
+
+	/* report lost writes even though the descriptor is gone */
+	if (!flushed) {
+		errno = EIO;
+		return -1;
+	}
+	return res;
+}
+
+
+ssize_t fuse_block_pread(int fd, void *buf, size_t count, off_t offset)
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (Fuse::Block_cache *cache = cache_of(fd))
+		return cache->pread((char *)buf, count, offset);
+
+	return ::pread(fd, buf, count, offset);
+}
+
+
+ssize_t fuse_block_pwrite(int fd, const void *buf, size_t count, off_t offset)
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (Fuse::Block_cache *cache = cache_of(fd))
+		return cache->pwrite((char const *)buf, count, offset);
+
+	return ::pwrite(fd, buf, count, offset);
+}
+
+
+ssize_t fuse_block_read(int fd, void *buf, size_t count)
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (Fuse::Block_cache *cache = cache_of(fd)) {
+		ssize_t const n = cache->pread((char *)buf, count, cache->pos());
+		cache->advance(n);
+		return n;
+	}
+
+	return ::read(fd, buf, count);
+}
+
+
+ssize_t fuse_block_write(int fd, const void *buf, size_t count)
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (Fuse::Block_cache *cache = cache_of(fd)) {
+		ssize_t const n = cache->pwrite((char const *)buf, count, cache->pos());
+		cache->advance(n);
+		return n;
+	}
+
+	return ::write(fd, buf, count);
+}
+
+
+off_t fuse_block_lseek(int fd, off_t offset, int whence)
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (Fuse::Block_cache *cache = cache_of(fd))
+		return cache->lseek(offset, whence);
+
+	return ::lseek(fd, offset, whence);
+}
+
+
+int fuse_block_fsync(int fd)
+{
+	Genode::Lock::Guard guard(_cache_lock);
+
+	if (Fuse::Block_cache *cache = cache_of(fd))
+		if (!cache->flush()) {
+			errno = EIO;
+			return -1;
+		}
+
+	return ::fsync(fd);
+}
+
+} /* extern "C" */
@@ -0,0 +1,213 @@
+/*
+ * \brief  Cache of KeyNote sessions with pre-parsed assertions
+ * \author agent
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <keynote/session_cache.h>
+
+/* libc includes */
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include <keynote/keynote.h>
+}
+
+
+struct Keynote::Session_cache::Entry
+{
+	unsigned long long hash;        /* of policy and credentials */
+	char              *policy;      /* copies to rule out hash collisions */
+	char              *credentials;
+	int                session;     /* KeyNote session ID, -1 if unused */
+	unsigned long      last_used;
+};
+
+
+/**
+ * 64-bit FNV-1a hash over both assertion texts
+ */
+static unsigned long long content_hash(char const *policy, char const *credentials)
+{
+	unsigned long long h = 0xcbf29ce484222325ULL;
+
+	auto feed = [&] (char const *s) {
+		for (; *s; ++s)
+			h = (h ^ (unsigned char)*s) * 0x100000001b3ULL;
+
+		/* separate the texts such that the split point is significant */
+		h = (h ^ 0xff) * 0x100000001b3ULL;
+	};
+
+	feed(policy);
+	feed(credentials);
+	return h;
+}
+
+
+/**
+ * Add all assertions of 'text' to a session
+ *
+ * \return false if an assertion could not be added
+ */
+static bool add_assertions(int session, char const *text, int flags)
+{
+	int num = 0;
+	char **decomposed = kn_read_asserts((char *)text, strlen(text), &num);
+	if (!decomposed)
+		return false;
+
+	bool ok = true;
+	for (int i = 0; i < num; i++) {
+		if (ok && kn_add_assertion(session, decomposed[i],
+		                           strlen(decomposed[i]), flags) == -1)
+			ok = false;
+		free(decomposed[i]);
+	}
+	free(decomposed);
+	return ok;
+}
+
+
+static void close_entry(Keynote::Session_cache::Entry &e)
+{
+	if (e.session != -1)
+		kn_close(e.session);
+	free(e.policy);
+	free(e.credentials);
+	e.session = -1, e.policy = nullptr, e.credentials = nullptr;
+}
+
+
+Keynote::Session_cache::Session_cache(unsigned capacity)
+:
+	_entries((Entry *)calloc(capacity ? capacity : 1, sizeof(Entry))),
+	_capacity(capacity ? capacity : 1)
+{
+	for (unsigned i = 0; _entries && i < _capacity; i++)
+		_entries[i].session = -1;
+}
+
+
+Keynote::Session_cache::~Session_cache()
+{
+	flush();
+	free(_entries);
+}
+
+
+void Keynote::Session_cache::flush()
+{
+	for (unsigned i = 0; _entries && i < _capacity; i++)
+		close_entry(_entries[i]);
+}
+
+
+Keynote::Session_cache::Entry *
+Keynote::Session_cache::_lookup(char const *policy, char const *credentials)
+{
+	unsigned long long const hash = content_hash(policy, credentials);
+
+	for (unsigned i = 0; i < _capacity; i++) {
+		Entry &e = _entries[i];
+		if (e.session != -1 && e.hash == hash
+		 && strcmp(e.policy, policy) == 0
+		 && strcmp(e.credentials, credentials) == 0)
+			return &e;
+	}
+	return nullptr;
+}
+
+
+Keynote::Session_cache::Entry *
+Keynote::Session_cache::_create(char const *policy, char const *credentials)
+{
+	/* use a free slot or evict the least recently used session */
+	Entry *victim = &_entries[0];
+	for (unsigned i = 0; i < _capacity; i++) {
+		Entry &e = _entries[i];
+		if (e.session == -1) { victim = &e; break; }
+		if (e.last_used < victim->last_used) victim = &e;
+	}
+
+	if (victim->session != -1)
+		_stats.evictions++;
+	close_entry(*victim);
+
+	int const session = kn_init();
+	if (session == -1)
+		return nullptr;
+
+	/* policy assertions are local and carry no signature */
+	if (!add_assertions(session, policy, ASSERT_FLAG_LOCAL)
+	 || !add_assertions(session, credentials, 0)) {
+		kn_close(session);
+		return nullptr;
+	}
+
+	victim->session     = session;
+	victim->policy      = strdup(policy);
+	victim->credentials = strdup(credentials);
+	if (!victim->policy || !victim->credentials) {
+		close_entry(*victim);
+		keynote_errno = ERROR_MEMORY;
+		return nullptr;
+	}
+
+	victim->hash = content_hash(policy, credentials);
+	return victim;
+}
+
+
+int Keynote::Session_cache::query(char const *policy, char const *credentials,
+                                  char const *authorizer,
+                                  Action const *actions, unsigned num_actions,
+                                  char **return_values, int num_return_values)
+{
+	if (!_entries) {
+		keynote_errno = ERROR_MEMORY;
+		return -1;
+	}
+
+	Entry *entry = _lookup(policy, credentials);
+	if (entry) {
+		_stats.hits++;
+	} else {
+		_stats.misses++;
+		entry = _create(policy, credentials);
+		if (!entry)
+			return -1;
+	}
+
+	entry->last_used = ++_clock;
+
+	int const session = entry->session;
+	int       result  = -1;
+
+	if (kn_add_authorizer(session, (char *)authorizer) == -1)
+		return -1;
+
+	bool actions_ok = true;
+	for (unsigned i = 0; i < num_actions && actions_ok; i++)
+		actions_ok = kn_add_action(session, (char *)actions[i].name,
+		                           (char *)actions[i].value, 0) != -1;
+
+	if (actions_ok)
+		result = kn_do_query(session, return_values, num_return_values);
+
+	/* leave the session as it was before the query */
+	int const saved_errno = keynote_errno;
+	kn_cleanup_action_environment(session);
+	kn_remove_authorizer(session, (char *)authorizer);
+	keynote_errno = saved_errno;
+
+	return actions_ok ? result : -1;
+}
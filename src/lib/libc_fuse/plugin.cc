@@ -79,6 +79,189 @@ extern "C" int link(const char *oldpath, const char *newpath)
 
 namespace {
 
+	/**
+	 * Snapshot of a directory
+	 *
+	 * The directory is read once when the first entries are requested and
+	 * then handed out piecewise by successive 'getdirentries' calls.
+	 * Entries of unknown type are completed by a stat(2) while filling
+	 * the snapshot, so each entry is queried at most once.
+	 */
+	struct Dir_cache
+	{
+		Genode::Allocator &alloc;
+
+		struct dirent *entries  = nullptr;
+		unsigned       count    = 0;
+		unsigned       capacity = 0;
+
+		/* index of the next entry handed out */
+		unsigned       position = 0;
+
+		Dir_cache(Genode::Allocator &alloc) : alloc(alloc) { }
+
+		~Dir_cache()
+		{
+			if (entries)
+				alloc.free(entries, capacity * sizeof (struct dirent));
+		}
+
+		struct dirent *append()
+		{
+			if (count == capacity) {
+				unsigned const new_capacity = capacity ? capacity * 2 : 64;
+
+				struct dirent *new_entries = nullptr;
+				if (!alloc.alloc(new_capacity * sizeof (struct dirent),
+				                 (void **)&new_entries))
+					return nullptr;
+
+				if (entries) {
+					Genode::memcpy(new_entries, entries,
+					               count * sizeof (struct dirent));
+					alloc.free(entries, capacity * sizeof (struct dirent));
+				}
+
+				entries  = new_entries;
+				capacity = new_capacity;
+			}
+
+			struct dirent *entry = &entries[count++];
+			Genode::memset(entry, 0, sizeof (struct dirent));
+			return entry;
+		}
+
+		/**
+		 * Filler passed to the readdir operation of the file system
+		 */
+		static int fill(void *dh, const char *name, const struct stat *sbuf, ::off_t)
+		{
+			static uint32_t fileno = 1;
+
+			Dir_cache &cache = *static_cast<Dir_cache *>(dh);
+
+			struct dirent *entry = cache.append();
+			if (!entry)
+				return 1;
+
+			if (sbuf) {
+				entry->d_fileno = sbuf->st_ino;
+				entry->d_type   = IFTODT(sbuf->st_mode);
+			} else
+				entry->d_type   = DT_UNKNOWN;
+
+			/* even in a valid sbuf the inode might by 0 */
+			if (entry->d_fileno == 0)
+				entry->d_fileno = fileno++;
+
+			Genode::strncpy(entry->d_name, name, sizeof (entry->d_name));
+			entry->d_namlen = Genode::strlen(entry->d_name);
+			entry->d_reclen = sizeof (struct dirent);
+			return 0;
+		}
+
+		int read(char const *path, struct fuse_file_info *file_info)
+		{
+			int res = Fuse::fuse()->op.readdir(path, this, fill, 0, file_info);
+			if (res != 0)
+				return res;
+
+			/*
+			 * We have to stat(2) each entry because there are FUSE file
+			 * systems which do not provide a valid struct stat entry in
+			 * its readdir() implementation because only d_ino and d_name
+			 * are specified by POSIX.
+			 */
+			for (unsigned i = 0; i < count; i++) {
+				struct dirent *entry = &entries[i];
+
+				if (entry->d_type != DT_UNKNOWN)
+					continue;
+
+				Genode::Path<4096> entry_path(entry->d_name, path);
+				struct stat sbuf;
+				if (Fuse::fuse()->op.getattr(entry_path.base(), &sbuf) == 0) {
+					entry->d_type   = IFTODT(sbuf.st_mode);
+					entry->d_fileno = sbuf.st_ino ? sbuf.st_ino : 1;
+				}
+			}
+			return 0;
+		}
+	};
+
+
+	/**
+	 * Buffer for coalescing small reads and writes of one file descriptor
+	 *
+	 * Reads smaller than the buffer are served from a read-ahead window
+	 * filled by one large read operation. Sequential writes smaller than
+	 * the buffer are collected and handed to the file system as one write
+	 * operation once the buffer is full, the write is not sequential, or
+	 * the data is needed by another operation.
+	 */
+	struct Io_buffer
+	{
+		enum { SIZE = 64*1024 };
+
+		Genode::Allocator &alloc;
+
+		char *data = nullptr;
+
+		/* file offset and length of the buffered data */
+		::off_t  start = 0;
+		::size_t length = 0;
+
+		enum Mode { EMPTY, READ, WRITE } mode = EMPTY;
+
+		Io_buffer(Genode::Allocator &alloc) : alloc(alloc) { }
+
+		~Io_buffer() { if (data) alloc.free(data, SIZE); }
+
+		bool allocated()
+		{
+			if (!data)
+				alloc.alloc(SIZE, (void **)&data);
+			return data != nullptr;
+		}
+
+		void invalidate()
+		{
+			mode   = EMPTY;
+			length = 0;
+		}
+
+		/**
+		 * Write back buffered data
+		 *
+		 * \return  0 on success, or -errno
+		 */
+		int flush(char const *path, struct fuse_file_info *file_info)
+		{
+			if (mode != WRITE)
+				return 0;
+
+			::size_t done = 0;
+			while (done < length) {
+				int res = Fuse::fuse()->op.write(path, data + done, length - done,
+				                                 start + done, file_info);
+				if (res < 0) {
+					invalidate();
+					return res;
+				}
+				if (res == 0)
+					break;
+				done += res;
+			}
+
+			/* the file system stopped taking data, the rest is lost */
+			bool const complete = (done == length);
+
+			invalidate();
+			return complete ? 0 : -EIO;
+		}
+	};
+
+
 	struct Plugin_context : Libc::Plugin_context
 	{
 		String<4096>          path;
@@ -88,6 +271,9 @@ namespace {
 
 		::off_t               offset;
 
+		Dir_cache            *dir_cache = nullptr;
+		Io_buffer             io_buffer { *env()->heap() };
+
 		Plugin_context(const char *p, int f)
 		:
 			path(p), flags(f), offset(0)
@@ -95,7 +281,16 @@ namespace {
 			Genode::memset(&file_info, 0, sizeof (struct fuse_file_info));
 		}
 
-		~Plugin_context() { }
+		~Plugin_context() { drop_dir_cache(); }
+
+		void drop_dir_cache()
+		{
+			if (dir_cache)
+				destroy(env()->heap(), dir_cache);
+			dir_cache = nullptr;
+		}
+
+		int flush() { return io_buffer.flush(path.string(), &file_info); }
 	};
 
 	static inline Plugin_context *context(Libc::File_descriptor *fd)
@@ -189,12 +384,17 @@ namespace {
 			{
 				Plugin_context *ctx = context(fd);
 
+				int const flushed = ctx->flush();
+				if (flushed != 0)
+					warning(__func__, ": could not write back '", ctx->path, "'");
+
 				Fuse::fuse()->op.release(ctx->path.string(), &ctx->file_info);
 
 				destroy(env()->heap(), ctx);
 				Libc::file_descriptor_allocator()->free(fd);
 
-				return 0;
+				/* report lost buffered writes to the application */
+				return check_result(flushed);
 			}
 
 			int fcntl(Libc::File_descriptor *fd, int cmd, long arg)
@@ -221,6 +421,10 @@ namespace {
 			{
 				Plugin_context *ctx = context(fd);
 
+				/* the file size must include buffered writes */
+				if (check_result(ctx->flush()))
+					return -1;
+
 				Genode::memset(buf, 0, sizeof (struct stat));
 
 				int res = Fuse::fuse()->op.getattr(ctx->path.string(), buf);
@@ -259,10 +463,31 @@ namespace {
 				return 0;
 			}
 
+			int fsync(Libc::File_descriptor *fd)
+			{
+				Plugin_context *ctx = context(fd);
+
+				if (check_result(ctx->flush()))
+					return -1;
+
+				int const res = Fuse::fuse()->op.fsync(ctx->path.string(), 0,
+				                                       &ctx->file_info);
+
+				/* the buffer is written, nothing more to do without fsync op */
+				if (res == -ENOSYS)
+					return 0;
+
+				return check_result(res);
+			}
+
 			int ftruncate(Libc::File_descriptor *fd, ::off_t length)
 			{
 				Plugin_context *ctx = context(fd);
 
+				if (check_result(ctx->flush()))
+					return -1;
+				ctx->io_buffer.invalidate();
+
 				int res = Fuse::fuse()->op.ftruncate(ctx->path.string(), length,
 				                                     &ctx->file_info);
 				if (res != 0) {
@@ -280,61 +505,39 @@ namespace {
 
 				if (nbytes < sizeof (struct dirent)) {
 					error(__func__, ": buf too small");
-					errno = ENOMEM;
+					errno = EINVAL;
 					return -1;
 				}
 
-				struct dirent *de = (struct dirent *)buf;
-				::memset(de, 0, sizeof (struct dirent));
-
-				struct fuse_dirhandle dh = {
-					.filler = Fuse::fuse()->filler,
-					.buf    = buf,
-					.size   = nbytes,
-					.offset = 0,
-				};
+				/* read the whole directory once, hand it out piecewise */
+				if (!ctx->dir_cache) {
+					ctx->dir_cache = new (env()->heap()) Dir_cache(*env()->heap());
 
-				int res = Fuse::fuse()->op.readdir(ctx->path.string(), &dh,
-				                                   Fuse::fuse()->filler, 0,
-				                                   &ctx->file_info);
-				if (res != 0) {
-					errno = -res;
-					return -1;
+					int res = ctx->dir_cache->read(ctx->path.string(),
+					                               &ctx->file_info);
+					if (res != 0) {
+						ctx->drop_dir_cache();
+						errno = -res;
+						return -1;
+					}
 				}
 
-				/**
-				 * We have to stat(2) each entry because there are FUSE file
-				 * systems which do not provide a valid struct stat entry in
-				 * its readdir() implementation because only d_ino and d_name
-				 * are specified by POSIX.
-				 */
-				::off_t offset = 0;
-				while (offset < dh.offset) {
-					struct dirent *entry = (struct dirent*)(buf + offset);
-
-					/* try to query the type of the file if the type is unknown  */
-					if (entry->d_type == DT_UNKNOWN) {
-						Genode::Path<4096> path(entry->d_name, ctx->path.string());
-						struct stat sbuf;
-						res = Fuse::fuse()->op.getattr(path.base(), &sbuf);
-						if (res == 0) {
-							entry->d_type   = IFTODT(sbuf.st_mode);
-							entry->d_fileno = sbuf.st_ino ? sbuf.st_ino : 1;
-						}
-					}
+				Dir_cache &cache = *ctx->dir_cache;
 
-					offset += sizeof (struct dirent);
-				}
+				unsigned const avail = cache.count - cache.position;
+				unsigned const n     = Genode::min((unsigned)(nbytes / sizeof (struct dirent)),
+				                                   avail);
 
-				/**
-				 * To prevent the libc from being stuck in an endless loop we
-				 * append an empty entry. This is a rather hacky solution but
-				 * for now it suffice.
-				 */
-				dh.offset += sizeof (struct dirent);
-				((struct dirent*)(buf + dh.offset))->d_reclen = 0;
+				Genode::memcpy(buf, &cache.entries[cache.position],
+				               n * sizeof (struct dirent));
 
-				return dh.offset;
+				if (basep)
+					*basep = cache.position * sizeof (struct dirent);
+
+				cache.position += n;
+
+				/* zero marks the end of the directory */
+				return n * sizeof (struct dirent);
 			}
 
 			::off_t lseek(Libc::File_descriptor *fd, ::off_t offset, int whence)
@@ -344,6 +547,10 @@ namespace {
 				switch (whence) {
 				case SEEK_SET:
 					ctx->offset = offset;
+
+					/* rewinddir(3) takes a fresh snapshot */
+					if (offset == 0)
+						ctx->drop_dir_cache();
 					return ctx->offset;
 
 				case SEEK_CUR:
@@ -433,17 +640,64 @@ namespace {
 			ssize_t read(Libc::File_descriptor *fd, void *buf, ::size_t count)
 			{
 				Plugin_context *ctx = context(fd);
+				Io_buffer      &b   = ctx->io_buffer;
 
-				int res = Fuse::fuse()->op.read(ctx->path.string(),
-				                                reinterpret_cast<char*>(buf),
-				                                count, ctx->offset, &ctx->file_info);
-
-				if (check_result(res))
+				if (check_result(ctx->flush()))
 					return -1;
 
-				ctx->offset += res;
+				/* large reads go directly to the file system */
+				if (count >= Io_buffer::SIZE || !b.allocated()) {
+					b.invalidate();
 
-				return res;
+					int res = Fuse::fuse()->op.read(ctx->path.string(),
+					                                reinterpret_cast<char*>(buf),
+					                                count, ctx->offset, &ctx->file_info);
+
+					if (check_result(res))
+						return -1;
+
+					ctx->offset += res;
+
+					return res;
+				}
+
+				char    *dst  = reinterpret_cast<char*>(buf);
+				::size_t done = 0;
+
+				while (done < count) {
+
+					bool const hit = b.mode == Io_buffer::READ
+					              && ctx->offset >= b.start
+					              && ctx->offset < b.start + (::off_t)b.length;
+
+					if (!hit) {
+						int res = Fuse::fuse()->op.read(ctx->path.string(), b.data,
+						                                Io_buffer::SIZE, ctx->offset,
+						                                &ctx->file_info);
+						if (res < 0) {
+							b.invalidate();
+							if (done) break;
+							return check_result(res);
+						}
+
+						/* end of file */
+						if (res == 0)
+							break;
+
+						b.mode   = Io_buffer::READ;
+						b.start  = ctx->offset;
+						b.length = res;
+					}
+
+					::size_t const pos = ctx->offset - b.start;
+					::size_t const n   = Genode::min(count - done, b.length - pos);
+
+					Genode::memcpy(dst + done, b.data + pos, n);
+					done        += n;
+					ctx->offset += n;
+				}
+
+				return done;
 			}
 
 			ssize_t readlink(const char *path, char *buf, ::size_t bufsiz)
@@ -502,17 +756,44 @@ namespace {
 			ssize_t write(Libc::File_descriptor *fd, const void *buf, ::size_t count)
 			{
 				Plugin_context *ctx = context(fd);
+				Io_buffer      &b   = ctx->io_buffer;
 
-				int res = Fuse::fuse()->op.write(ctx->path.string(),
-				                                 reinterpret_cast<const char*>(buf),
-				                                 count, ctx->offset, &ctx->file_info);
+				if (b.mode == Io_buffer::READ)
+					b.invalidate();
 
-				if (check_result(res))
-					return -1;
+				bool const sequential = b.mode == Io_buffer::WRITE
+				                     && ctx->offset == b.start + (::off_t)b.length
+				                     && b.length + count <= Io_buffer::SIZE;
+
+				if (b.mode == Io_buffer::WRITE && !sequential)
+					if (check_result(ctx->flush()))
+						return -1;
 
-				ctx->offset += res;
+				/* large writes go directly to the file system */
+				if (count >= Io_buffer::SIZE || !b.allocated()) {
+					int res = Fuse::fuse()->op.write(ctx->path.string(),
+					                                 reinterpret_cast<const char*>(buf),
+					                                 count, ctx->offset, &ctx->file_info);
 
-				return res;
+					if (check_result(res))
+						return -1;
+
+					ctx->offset += res;
+
+					return res;
+				}
+
+				if (b.mode == Io_buffer::EMPTY) {
+					b.mode   = Io_buffer::WRITE;
+					b.start  = ctx->offset;
+					b.length = 0;
+				}
+
+				Genode::memcpy(b.data + b.length, buf, count);
+				b.length    += count;
+				ctx->offset += count;
+
+				return count;
 			}
 
 	};
@@ -41,6 +41,11 @@
 
 struct Blockdev
 {
+	enum {
+		TX_BUF_SIZE    = 512*1024,
+		MAX_CHUNK_SIZE = 128*1024,   /* keeps several packets in flight */
+	};
+
 	struct ext4_blockdev       ext4_blockdev;
 	struct ext4_blockdev_iface ext4_blockdev_iface;
 	unsigned char              ext4_block_buffer[4096];
@@ -49,9 +54,11 @@ struct Blockdev
 	Genode::Allocator     &_alloc;
 	Genode::Allocator_avl  _tx_alloc { &_alloc };
 
-	Block::Connection<>        _block { _env, &_tx_alloc, 512*1024 };
+	Block::Connection<>        _block { _env, &_tx_alloc, TX_BUF_SIZE };
 	Block::Session::Info const _info  { _block.info() };
 
+	Lwext4::Block_stats stats { };
+
 	Blockdev(Genode::Env &env, Genode::Allocator &alloc)
 	: _env(env), _alloc(alloc) { }
 
@@ -66,33 +73,99 @@ static int blockdev_open(struct ext4_blockdev *bdev)  { return EOK; }
 static int blockdev_close(struct ext4_blockdev *bdev) { return EOK; }
 
 
+/**
+ * Transfer 'count' blocks starting at 'lba'
+ *
+ * lwext4 hands over whole runs of physically contiguous blocks for the
+ * aligned part of file reads and writes. Such a run is split into chunks
+ * that fit into the packet buffer and the chunks are submitted back to
+ * back, so the device is kept busy instead of waiting for each packet.
+ */
+static int blockdev_transfer(Blockdev                          &bd,
+                             Block::Packet_descriptor::Opcode   op,
+                             char                              *buf,
+                             uint64_t                           lba,
+                             uint32_t                           count)
+{
+	Block::Connection<> &b = bd.block();
+
+	Genode::size_t const block_size = bd.block_size();
+	uint32_t       const chunk      =
+		Genode::max(1UL, (unsigned long)(Blockdev::MAX_CHUNK_SIZE / block_size));
+
+	bool const write = op == Block::Packet_descriptor::WRITE;
+
+	Lwext4::Block_stats &stats = bd.stats;
+	if (write) { ++stats.writes; stats.blocks_written += count; }
+	else       { ++stats.reads;  stats.blocks_read    += count; }
+
+	uint32_t submitted = 0;
+	unsigned in_flight = 0;
+	int      result    = EOK;
+
+	while (in_flight || (result == EOK && submitted < count)) {
+
+		while (result == EOK && submitted < count && b.tx()->ready_to_submit()) {
+
+			uint32_t const n = Genode::min(chunk, count - submitted);
+
+			Block::Packet_descriptor p;
+			try {
+				p = Block::Packet_descriptor(b.tx()->alloc_packet(n*block_size),
+				                             op, lba + submitted, n);
+			} catch (Block::Session::Tx::Source::Packet_alloc_failed) {
+				if (!in_flight) {
+					Genode::error("could not allocate packet for ", n, " blocks");
+					result = EIO;
+				}
+				break;
+			}
+
+			if (write)
+				Genode::memcpy(b.tx()->packet_content(p),
+				               buf + submitted*block_size, n*block_size);
+
+			b.tx()->submit_packet(p);
+			submitted += n;
+			++in_flight;
+
+			stats.max_queue_depth = Genode::max(stats.max_queue_depth, in_flight);
+		}
+
+		if (!in_flight)
+			break;
+
+		Block::Packet_descriptor p = b.tx()->get_acked_packet();
+		--in_flight;
+
+		Genode::size_t const size = p.block_count()*block_size;
+
+		if (p.succeeded() && p.size() == size) {
+			if (!write)
+				Genode::memcpy(buf + (p.block_number() - lba)*block_size,
+				               b.tx()->packet_content(p), size);
+		} else {
+			Genode::error("could not ", write ? "write" : "read",
+			              " lba: ", p.block_number(), " count: ", p.block_count());
+			result = EIO;
+		}
+
+		b.tx()->release_packet(p);
+	}
+
+	return result;
+}
+
+
 static int blockdev_bread(struct ext4_blockdev *bdev,
                           void                 *dest,
                           uint64_t              lba,
                           uint32_t              count)
 {
-	Blockdev            &bd = *reinterpret_cast<Blockdev*>(bdev);
-	Block::Connection<> &b  = bd.block();
-
-	Genode::size_t const size = bd.block_size() * count;
-
-	Block::Packet_descriptor p(b.tx()->alloc_packet(size),
-	                           Block::Packet_descriptor::READ,
-	                           lba, count);
-	b.tx()->submit_packet(p);
-	p = b.tx()->get_acked_packet();
-
-	int result = EIO;
-	if (p.succeeded() && p.size() == size) {
-		char const * const content = b.tx()->packet_content(p);
-		Genode::memcpy(dest, content, size);
-		result = EOK;
-	} else {
-		Genode::error("could not read lba: ", lba, " count: ", count);
-	}
+	Blockdev &bd = *reinterpret_cast<Blockdev*>(bdev);
 
-	b.tx()->release_packet(p);
-	return result;
+	return blockdev_transfer(bd, Block::Packet_descriptor::READ,
+	                         (char *)dest, lba, count);
 }
 
 
@@ -104,29 +177,8 @@ static int blockdev_bwrite(struct ext4_blockdev *bdev,
 	Blockdev &bd = *reinterpret_cast<Blockdev*>(bdev);
 	if (!bd.writeable()) { return EIO; }
 
-	Block::Connection<>    &b = bd.block();
-	Genode::size_t const size = bd.block_size() * count;
-
-	Block::Packet_descriptor p(b.tx()->alloc_packet(size),
-	                           Block::Packet_descriptor::WRITE,
-	                           lba, count);
-
-	char * const content = b.tx()->packet_content(p);
-	Genode::memcpy(content, src, size);
-
-	b.tx()->submit_packet(p);
-	p = b.tx()->get_acked_packet();
-
-	int result = EIO;
-	if (p.succeeded() && p.size() == size) {
-		result = EOK;
-	} else {
-		Genode::error("could not write lba: ", lba, " count: ", count);
-	}
-
-	b.tx()->release_packet(p);
-
-	return result;
+	return blockdev_transfer(bd, Block::Packet_descriptor::WRITE,
+	                         (char *)src, lba, count);
 }
 
 /*
@@ -161,3 +213,11 @@ struct ext4_blockdev *Lwext4::block_init(Genode::Env &env, Genode::Allocator &al
 
 	return reinterpret_cast<ext4_blockdev*>(&*_blockdev);
 }
+
+
+Lwext4::Block_stats const &Lwext4::block_stats()
+{
+	static Block_stats const none { };
+
+	return _blockdev.constructed() ? _blockdev->stats : none;
+}
@@ -16,7 +16,10 @@ namespace Remote_rom {
 	class Backend_client;
 };
 
-class Remote_rom::Content_receiver
+/**
+ * Reception state of one ROM module
+ */
+class Remote_rom::Content_receiver : public Genode::List<Content_receiver>::Element
 {
 	private:
 		enum {
@@ -37,7 +40,7 @@ class Remote_rom::Content_receiver
 		/* timeouts and general object management*/
 		Timer::One_shot_timeout<Content_receiver> _timeout;
 		Backend_client            &_backend;
-		Rom_receiver_base         *_frontend       { nullptr };
+		Rom_receiver_base         &_frontend;
 
 		size_t _write_offset()
 		{ return _offset + _next_packet_id * MAX_PAYLOAD_SIZE; }
@@ -82,22 +85,16 @@ class Remote_rom::Content_receiver
 
 	public:
 		Content_receiver(Timer::Connection &timer,
-		                 Backend_client    &backend)
+		                 Backend_client    &backend,
+		                 Rom_receiver_base &frontend)
 		: _timeout(timer, *this, &Content_receiver::timeout_handler),
-		  _backend(backend)
+		  _backend(backend), _frontend(frontend)
 		{ }
 
-		void register_receiver(Rom_receiver_base *frontend)
-		{
-			_frontend = frontend;
-		}
-
 		void start_new_content(unsigned hash,
 		                       size_t   size)
 		{
-			if (!_frontend) return;
-
-			_write_ptr      = _frontend->start_new_content(hash, size);
+			_write_ptr      = _frontend.start_new_content(hash, size);
 			_buf_size       = _write_ptr ? size : 0;
 			_offset         = 0;
 			_window_id      = 0;
@@ -114,10 +111,10 @@ class Remote_rom::Content_receiver
 		 **********************/
 
 		unsigned content_hash()   const
-		{ return _frontend ? _frontend->content_hash() : 0; }
+		{ return _frontend.content_hash(); }
 
 		char const *module_name() const
-		{ return _frontend ? _frontend->module_name()  : ""; }
+		{ return _frontend.module_name(); }
 
 		size_t content_size() const
 		{ return _buf_size; }
@@ -146,21 +143,27 @@ class Remote_rom::Backend_client :
 	private:
 		friend class Content_receiver;
 
-		Content_receiver   _content_receiver { _timer, *this };
+		Genode::Allocator              &_alloc;
+		Genode::List<Content_receiver>  _receivers { };
 
 		Backend_client(Backend_client &);
 		Backend_client &operator= (Backend_client &);
 
-		void update(const char* module_name)
+		Content_receiver *_lookup(const char *module_name)
 		{
-			/* check module name */
-			if (Genode::strcmp(module_name, _content_receiver.module_name()))
-				return;
+			for (Content_receiver *r = _receivers.first(); r; r = r->next())
+				if (!Genode::strcmp(module_name, r->module_name(),
+				                    Packet::MAX_NAME_LEN))
+					return r;
+			return nullptr;
+		}
 
+		void update(Content_receiver const &recv)
+		{
 			if (_verbose)
-				Genode::log("sending UPDATE(", _content_receiver.module_name(), ")");
+				Genode::log("sending UPDATE(", recv.module_name(), ")");
 
-			transmit_notification(Packet::UPDATE, _content_receiver);
+			transmit_notification(Packet::UPDATE, recv);
 		}
 
 		void send_ack(Content_receiver const &recv);
@@ -173,14 +176,17 @@ class Remote_rom::Backend_client :
 		               Genode::Allocator &alloc,
 		               Genode::Xml_node config,
 		               Genode::Xml_node policy)
-		: Backend_base(env, alloc, config, policy)
+		: Backend_base(env, alloc, config, policy), _alloc(alloc)
 		{ }
 
 
 		void register_receiver(Rom_receiver_base *receiver) override
 		{
-			/* TODO support multiple receivers (ROM names) */
-			_content_receiver.register_receiver(receiver);
+			if (!receiver || _lookup(receiver->module_name()))
+				return;
+
+			_receivers.insert(new (_alloc)
+				Content_receiver(_timer, *this, *receiver));
 
 			/*
 			 * FIXME request update on startup
@@ -234,8 +240,8 @@ void Remote_rom::Backend_client::send_ack(Content_receiver const &recv)
 
 	AckPacket &ack =
 		pak.construct_at_data<AckPacket>(size_guard);
-	ack.window_id(_content_receiver.window_id());
-	ack.ack_until(_content_receiver.ack_until());
+	ack.window_id(recv.window_id());
+	ack.ack_until(recv.ack_until());
 
 	/* fill in header values that need the packet to be complete already */
 	udp.length(size_guard.head_size() - udp_off);
@@ -248,7 +254,7 @@ void Remote_rom::Backend_client::send_ack(Content_receiver const &recv)
 	submit_tx_packet(pd);
 
 	if (_verbose)
-		Genode::log("Sent ACK for window ", _content_receiver.window_id());
+		Genode::log("Sent ACK for window ", recv.window_id());
 }
 
 void Remote_rom::Backend_client::receive(Packet     &packet,
@@ -258,6 +264,10 @@ void Remote_rom::Backend_client::receive(Packet     &packet,
 	{
 		case Packet::SIGNAL:
 		{
+			Content_receiver *recv = _lookup(packet.module_name());
+			if (!recv)
+				return;
+
 			const NotificationPacket &signal
 				= packet.data<NotificationPacket>(size_guard);
 
@@ -268,34 +278,34 @@ void Remote_rom::Backend_client::receive(Packet     &packet,
 						      signal.content_size());
 
 			/* start new content with given size and hash */
-			_content_receiver.start_new_content(
-					packet.content_hash(),
-					signal.content_size());
+			recv->start_new_content(packet.content_hash(),
+			                        signal.content_size());
 
 			/* send update request */
-			update(packet.module_name());
+			update(*recv);
 
 			break;
 		}
 		case Packet::DATA:
 		{
 			/* check module name */
-			if (Genode::strcmp(packet.module_name(), _content_receiver.module_name()))
+			Content_receiver *recv = _lookup(packet.module_name());
+			if (!recv)
 				return;
 
 			/* check hash */
-			if (packet.content_hash() != _content_receiver.content_hash()) {
+			if (packet.content_hash() != recv->content_hash()) {
 				Genode::warning("ignoring hash mismatch ",
 				                Genode::Hex(packet.content_hash()),
 				                " != ",
-				                Genode::Hex(_content_receiver.content_hash()));
+				                Genode::Hex(recv->content_hash()));
 				return;
 			}
 
 			const DataPacket &data = packet.data<DataPacket>(size_guard);
 			size_guard.consume_head(data.payload_size());
 
-			_content_receiver.accept_packet(data);
+			recv->accept_packet(data);
 
 			break;
 		}
@@ -322,7 +332,7 @@ bool Remote_rom::Content_receiver::accept_packet(const DataPacket &p)
 	/**
 	 * TODO replace return value with exceptions
 	 */
-	if (complete() || !_frontend) return false;
+	if (complete()) return false;
 
 	if (_timeout.scheduled())
 		_timeout.discard();
@@ -380,7 +390,7 @@ bool Remote_rom::Content_receiver::accept_packet(const DataPacket &p)
 		_backend.send_ack(*this);
 
 	if (complete())
-		_frontend->commit_new_content();
+		_frontend.commit_new_content();
 	else
 		_timeout.schedule(Microseconds(TIMEOUT_DATA_US));
 
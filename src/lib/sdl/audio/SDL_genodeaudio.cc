@@ -21,6 +21,7 @@
 #include <base/thread.h>
 #include <audio_out_session/connection.h>
 #include <util/reconstructible.h>
+#include <world/pcm_convert.h>
 
 /* local includes */
 #include <SDL_genode_internal.h>
@@ -240,10 +241,9 @@ static void GENODEAUD_PlayAudio(_THIS)
 	unsigned ppos = c[0]->stream()->packet_position(p[0]);
 	p[1] = c[1]->stream()->get(ppos);
 
-	for (int sample = 0; sample < Audio_out::PERIOD; sample++)
-		for (int channel = 0; channel < AUDIO_CHANNELS; channel++)
-			p[channel]->content()[sample] =
-				volume * (float)(((int16_t*)_this->hidden->mixbuf)[sample * AUDIO_CHANNELS + channel]) / 32768;
+	Pcm::s16_to_planar(p[0]->content(), p[1]->content(),
+	                   (int16_t const *)_this->hidden->mixbuf,
+	                   Audio_out::PERIOD, volume);
 
 	for (int channel = 0; channel < AUDIO_CHANNELS; channel++) {
 		_this->hidden->audio[channel]->submit(p[channel]);
@@ -45,6 +45,91 @@ extern Genode::Lock event_lock;
 extern Video        video_events;
 
 
+/**
+ * Accumulator of dirty rectangles
+ *
+ * Rectangles are merged into at most 'MAX_REGIONS' bounding boxes so
+ * that a long list of small updates results in only a few refresh
+ * operations. A rectangle is kept separate while there is room and
+ * joining it would cover pixels that are not dirty, otherwise it is
+ * joined with the box that grows the least.
+ */
+struct Dirty_regions
+{
+	enum { MAX_REGIONS = 4 };
+
+	struct Box
+	{
+		int x1, y1, x2, y2;
+
+		long area() const { return (long)(x2 - x1) * (y2 - y1); }
+
+		Box join(Box const &o) const
+		{
+			return Box { Genode::min(x1, o.x1), Genode::min(y1, o.y1),
+			             Genode::max(x2, o.x2), Genode::max(y2, o.y2) };
+		}
+	};
+
+	Box _boxes[MAX_REGIONS];
+	int _count = 0;
+
+	/**
+	 * Add rectangle, clipped to the area 'w' x 'h'
+	 */
+	void add(int x, int y, int w, int h, int max_w, int max_h)
+	{
+		Box const r { Genode::max(x, 0), Genode::max(y, 0),
+		              Genode::min(x + w, max_w), Genode::min(y + h, max_h) };
+
+		if (r.x2 <= r.x1 || r.y2 <= r.y1)
+			return;
+
+		int  best      = -1;
+		long best_cost = 0;
+		for (int i = 0; i < _count; i++) {
+			long const cost = _boxes[i].join(r).area()
+			                - _boxes[i].area() - r.area();
+			if (best < 0 || cost < best_cost) {
+				best      = i;
+				best_cost = cost;
+			}
+		}
+
+		if (best < 0 || (best_cost > 0 && _count < MAX_REGIONS))
+			_boxes[_count++] = r;
+		else
+			_boxes[best] = _boxes[best].join(r);
+	}
+
+	template <typename FN>
+	void for_each(FN const &fn) const
+	{
+		for (int i = 0; i < _count; i++)
+			fn(_boxes[i].x1, _boxes[i].y1,
+			   _boxes[i].x2 - _boxes[i].x1, _boxes[i].y2 - _boxes[i].y1);
+	}
+};
+
+
+/**
+ * Convert XRGB8888 pixels of the back buffer to the RGB565 nitpicker buffer
+ */
+static void convert_to_rgb565(Genode::uint16_t *dst, Genode::uint32_t const *src,
+                              int pitch, int x, int y, int w, int h)
+{
+	for (int line = y; line < y + h; line++) {
+		Genode::uint32_t const *s = src + line*pitch + x;
+		Genode::uint16_t       *d = dst + line*pitch + x;
+
+		for (int i = 0; i < w; i++) {
+			Genode::uint32_t const p = s[i];
+			d[i] = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+		}
+	}
+}
+
+
 extern "C" {
 
 #include <dlfcn.h>
@@ -92,10 +177,16 @@ extern "C" {
 		 ** Framebuffer::Session Interface **
 		 ************************************/
 
-		Genode::Dataspace_capability dataspace(int width, int height)
+		/**
+		 * Request buffer
+		 *
+		 * \param pages  number of vertically stacked screens within the
+		 *               buffer, used for page flipping
+		 */
+		Genode::Dataspace_capability dataspace(int width, int height, int pages)
 		{
 			_nitpicker.buffer(
-				::Framebuffer::Mode(width, height, Framebuffer::Mode::RGB565),
+				::Framebuffer::Mode(width, height*pages, Framebuffer::Mode::RGB565),
 				false);
 
 			::Framebuffer::Mode mode = _nitpicker.framebuffer()->mode();
@@ -108,11 +199,22 @@ extern "C" {
 			typedef Nitpicker::Session::Command Command;
 			_nitpicker.enqueue<Command::Geometry>(
 				_view, Rect(Point(0, 0), area));
+			_nitpicker.enqueue<Command::Offset>(_view, Point(0, 0));
 			_nitpicker.execute();
 
 			return _nitpicker.framebuffer()->dataspace();
 		}
 
+		/**
+		 * Show the buffer content starting at line 'y' within the view
+		 */
+		void show(int y)
+		{
+			typedef Nitpicker::Session::Command Command;
+			_nitpicker.enqueue<Command::Offset>(_view, Nitpicker::Point(0, -y));
+			_nitpicker.execute();
+		}
+
 		Framebuffer::Mode mode() const {
 			return _nitpicker.mode(); }
 
@@ -339,7 +441,7 @@ extern "C" {
 		device->FillHWRect       = 0;
 		device->SetHWColorKey    = 0;
 		device->SetHWAlpha       = 0;
-		device->FlipHWSurface    = 0;
+		device->FlipHWSurface    = Genode_Fb_FlipHWSurface;
 		device->SetCaption       = 0;
 		device->SetIcon          = 0;
 		device->IconifyWindow    = 0;
@@ -426,17 +528,32 @@ extern "C" {
 			global_env().rm().detach(t->hidden->buffer);
 			t->hidden->buffer = nullptr;
 		}
+
+		if (t->hidden->shadow) {
+			SDL_free(t->hidden->shadow);
+			t->hidden->shadow = nullptr;
+		}
 	}
 
 
 	/**
-	 * Any mode is okay if the pixel format is 16bit
+	 * Any mode is okay if the pixel format is 16bit or 32bit
+	 *
+	 * 32-bit surfaces are backed by a local buffer that is converted to the
+	 * nitpicker buffer on update, which is cheaper than the generic shadow
+	 * surface SDL would use otherwise.
 	 */
 	SDL_Rect **Genode_Fb_ListModes(SDL_VideoDevice *t,
 	                               SDL_PixelFormat *format,
 	                               Uint32 flags)
 	{
-		return (SDL_Rect **)((format->BitsPerPixel == 16) ? -1 : 0);
+		switch (format->BitsPerPixel) {
+		case 16:
+		case 32:
+			return (SDL_Rect **)-1;
+		default:
+			return 0;
+		}
 	}
 
 
@@ -461,18 +578,25 @@ extern "C" {
 		}
 
 		/*
-		 * XXX there is something wrong with how this is used now.
-		 *     SDL_Flip() is going to call FlipHWSurface which was never
-		 *     implemented and leads to a nullptr function call.
+		 * Surfaces matching the depth of the nitpicker buffer are drawn
+		 * directly into it. Double buffering is then implemented by
+		 * flipping between two pages of the buffer via the view offset.
+		 * Other depths are drawn into a back buffer that is converted
+		 * on update or flip.
 		 */
-		if (flags & SDL_DOUBLEBUF) {
-			Genode::warning("disable requested double-buffering");
-			flags &= ~SDL_DOUBLEBUF;
+		int  const fb_bpp = 8*scr_mode.bytes_per_pixel();
+		bool const native = (bpp == fb_bpp) || (flags & SDL_OPENGL);
+		bool const dbuf   = flags & SDL_DOUBLEBUF;
+		int  const pages  = (native && dbuf && !(flags & SDL_OPENGL)) ? 2 : 1;
+
+		if (!native && !(bpp == 32 && fb_bpp == 16)) {
+			Genode::error("unsupported depth ", bpp, " for ", fb_bpp, "-bit framebuffer");
+			return nullptr;
 		}
 
 		/* Map the buffer */
 		Genode::Dataspace_capability fb_ds_cap =
-			framebuffer->dataspace(width, height);
+			framebuffer->dataspace(width, height, pages);
 		if (!fb_ds_cap.valid()) {
 			Genode::error("could not request dataspace for frame buffer");
 			return nullptr;
@@ -482,6 +606,11 @@ extern "C" {
 			global_env().rm().detach(t->hidden->buffer);
 		}
 
+		if (t->hidden->shadow) {
+			SDL_free(t->hidden->shadow);
+			t->hidden->shadow = nullptr;
+		}
+
 		t->hidden->buffer = global_env().rm().attach(fb_ds_cap);
 
 		if (!t->hidden->buffer) {
@@ -489,19 +618,41 @@ extern "C" {
 			return nullptr;
 		}
 
-		Genode::log("Set video mode to: ", width, "x", height, "@", bpp);
+		SDL_memset(t->hidden->buffer, 0, width * height * pages * (fb_bpp / 8));
 
-		SDL_memset(t->hidden->buffer, 0, width * height * (bpp / 8));
+		if (!native) {
+			t->hidden->shadow = SDL_malloc(width * height * (bpp / 8));
+			if (!t->hidden->shadow) {
+				Genode::error("could not allocate back buffer for requested mode");
+				return nullptr;
+			}
+			SDL_memset(t->hidden->shadow, 0, width * height * (bpp / 8));
+		}
+
+		Genode::log("Set video mode to: ", width, "x", height, "@", bpp,
+		            native ? "" : " (converted)",
+		            dbuf   ? " double-buffered" : "");
+
+		Uint32 const rmask = bpp == 32 ? 0x00ff0000 : 0;
+		Uint32 const gmask = bpp == 32 ? 0x0000ff00 : 0;
+		Uint32 const bmask = bpp == 32 ? 0x000000ff : 0;
 
-		if (!SDL_ReallocFormat(current, bpp, 0, 0, 0, 0) ) {
+		if (!SDL_ReallocFormat(current, bpp, rmask, gmask, bmask, 0) ) {
 			Genode::error("couldn't allocate new pixel format for requested mode");
 			return nullptr;
 		}
 
+		/* SDL_Flip() only calls FlipHWSurface for hardware surfaces */
+		if (dbuf)
+			flags |= SDL_HWSURFACE;
+
 		/* Set up the new mode framebuffer */
 		current->flags = flags | SDL_FULLSCREEN;
 		t->hidden->w = current->w = width;
 		t->hidden->h = current->h = height;
+		t->hidden->bpp   = bpp;
+		t->hidden->pages = pages;
+		t->hidden->page  = pages > 1 ? 1 : 0;
 		current->pitch = current->w * (bpp / 8);
 
 #if defined(SDL_VIDEO_OPENGL)
@@ -514,7 +665,11 @@ extern "C" {
 		 * XXX if SDL ever wants to free the pixels pointer,
 		 *     free() in the libc will trigger a page-fault
 		 */
-		current->pixels = t->hidden->buffer;
+		if (t->hidden->shadow)
+			current->pixels = t->hidden->shadow;
+		else
+			current->pixels = (char *)t->hidden->buffer
+			                + t->hidden->page * height * current->pitch;
 		return current;
 	}
 
@@ -555,13 +710,51 @@ extern "C" {
 	}
 
 
+	/**
+	 * Refresh area of the current page, converting the back buffer if needed
+	 */
+	static void _update(SDL_VideoDevice *t, int x, int y, int w, int h)
+	{
+		if (t->hidden->shadow)
+			convert_to_rgb565((Genode::uint16_t *)t->hidden->buffer,
+			                  (Genode::uint32_t const *)t->hidden->shadow,
+			                  t->hidden->w, x, y, w, h);
+
+		framebuffer->refresh(x, y + t->hidden->page * t->hidden->h, w, h);
+	}
+
+
 	static void Genode_Fb_UpdateRects(SDL_VideoDevice *t, int numrects,
 	                                  SDL_Rect *rects)
 	{
-		int i;
-		for(i=0;i<numrects;i++) {
-			framebuffer->refresh(rects[i].x, rects[i].y, rects[i].w, rects[i].h);
-		}
+		Dirty_regions dirty;
+		for (int i = 0; i < numrects; i++)
+			dirty.add(rects[i].x, rects[i].y, rects[i].w, rects[i].h,
+			          t->hidden->w, t->hidden->h);
+
+		dirty.for_each([&] (int x, int y, int w, int h) {
+			_update(t, x, y, w, h); });
+	}
+
+
+	/**
+	 * Present the back buffer of a double-buffered screen
+	 */
+	static int Genode_Fb_FlipHWSurface(SDL_VideoDevice *t,
+	                                   SDL_Surface *surface)
+	{
+		_update(t, 0, 0, t->hidden->w, t->hidden->h);
+
+		if (t->hidden->pages < 2)
+			return 0;
+
+		/* show the page just drawn and continue with the other one */
+		framebuffer->show(t->hidden->page * t->hidden->h);
+
+		t->hidden->page = !t->hidden->page;
+		surface->pixels = (char *)t->hidden->buffer
+		                + t->hidden->page * t->hidden->h * surface->pitch;
+		return 0;
 	}
 
 
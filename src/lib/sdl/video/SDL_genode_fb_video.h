@@ -34,7 +34,11 @@
 /* Private display data */
 struct SDL_PrivateVideoData {
     int w, h;
-    void *buffer;
+    void *buffer;   /* attached nitpicker buffer */
+    void *shadow;   /* back buffer if the depth differs from nitpicker's */
+    int bpp;        /* depth of the SDL screen surface */
+    int pages;      /* number of pages within the nitpicker buffer */
+    int page;       /* page currently drawn into */
 };
 
 /**
@@ -65,6 +69,7 @@ static void Genode_Fb_FreeHWSurface(SDL_VideoDevice *t, SDL_Surface *surface);
  */
 static void Genode_Fb_UpdateRects(SDL_VideoDevice *t, int numrects,
                                   SDL_Rect *rects);
+static int Genode_Fb_FlipHWSurface(SDL_VideoDevice *t, SDL_Surface *surface);
 
 /**
  * OpenGL functions
@@ -1,53 +1,188 @@
-import std/parseopt, std/streams
+import std/parseopt, std/streams, std/strutils, std/tables, std/times
+import std/threadpool, std/cpuinfo
 import sphincs/shake256_192f
 import nimcrypto.hash, nimcrypto/keccak
 
+const hashBufferSize = 1 shl 16
+  ## Files are hashed in chunks of this size to keep the
+  ## number of VFS round-trips low for large artifacts.
+
 proc hashFile(path: string): string =
-  let fs = openFileStream(path, fmRead)
+  var f: File
+  if not open(f, path, fmRead):
+    raise newException(IOError, "cannot open: " & path)
+  defer: close f
   result = newString(32)
   var
     ctx: sha3_256
-    buf: array[512, byte]
+    buf = newSeq[byte](hashBufferSize)
   let bp = addr buf[0]
   init ctx
-  while not fs.atEnd:
-    let n = fs.readData(bp, buf.len)
+  while true:
+    let n = f.readBuffer(bp, buf.len)
+    if n <= 0: break
     ctx.update(bp, n.uint)
-  close fs
   var d = finish ctx
   copyMem(result[0].addr, d.data[0].addr, result.len)
 
+proc hexDigest(digest: string): string =
+  const alphabet = "0123456789abcdef"
+  result = newString(digest.len*2)
+  for i, c in digest.pairs:
+    result[i*2] = alphabet[c.int shr 4]
+    result[i*2+1] = alphabet[c.int and 0xf]
+
 proc readPair(path: string): KeyPair =
   let fs = openFileStream path
   defer: close fs
   doAssert(fs.readData(result.addr, sizeof(result)) == sizeof(result))
 
-let rngStr = openFileStream("/dev/random")
+var rngFile {.threadvar.}: File
+  ## Each worker thread reads the RNG through its own handle.
+
 proc readDevRand(p: pointer; size: int) =
-  let n = rngStr.readData(p, size)
+  if rngFile.isNil and not open(rngFile, "/dev/random"):
+    raise newException(IOError, "cannot open /dev/random")
+  let n = rngFile.readBuffer(p, size)
   doAssert(n == size, "short read from RNG")
 
+proc signDigest(pair: KeyPair; digest: string; latency: ptr int64): string =
+  ## Sign on a worker thread, the latency in microseconds
+  ## is stored at ``latency``.
+  let start = epochTime()
+  result = pair.sign(digest, readDevRand)
+  latency[] = int64((epochTime() - start) * 1_000_000)
+
 proc signPath(pair: KeyPair; path: string) =
   let
     digest = hashFile path
     sig = pair.sign(digest, readDevRand)
   writeFile(path & ".sphincs", sig)
 
-proc main() =
+when defined(genode):
+  import std/xmltree, std/xmlparser, std/os
+  import genode/reports, genode/roms
 
-  var
-    pair: KeyPair
-    argi = 0
-  for kind, key, val in getopt():
-    if kind != cmdArgument:
-      quit("invalid argument " & key & val)
-    if argi == 0:
-      pair = readPair(key)
-    else:
-      signPath(pair, key)
-    inc argi
+  proc xml(rom: RomClient): XmlNode =
+    let s = rom.newStream
+    result = s.parseXml
+    close s
+
+  proc previousDigests(env: GenodeEnv; label: string): Table[string, string] =
+    ## Digests of the files signed by a previous run, read
+    ## from a "signatures" report fed back in as ROM.
+    result = initTable[string, string]()
+    if label.len == 0: return
+    try:
+      let rom = env.newRomClient(label)
+      defer: close rom
+      for x in rom.xml.findAll("file"):
+        if x.attr("status") != "failed":
+          result[x.attr("path")] = x.attr("digest")
+    except:
+      echo "no previous signatures at ", label
+
+  componentConstructHook = proc (env: GenodeEnv) =
+    let report = env.newReportClient("signatures")
+
+    proc handleConfig(rom: RomClient) =
+      ## Files of the manifest are hashed in order and signed
+      ## on the thread pool. Files with the same digest as in
+      ## the previous signature manifest are skipped.
+      let
+        config = rom.xml
+        pair = readPair(config.attr("secret"))
+        previous = env.previousDigests(config.attr("previous"))
+        start = epochTime()
+      var manifest: XmlNode
+      block:
+        let manifestRom = env.newRomClient(config.attr("manifest"))
+        defer: close manifestRom
+        manifest = manifestRom.xml
+
+      let workers =
+        try: parseInt(config.attr("workers"))
+        except: countProcessors()
+      setMaxPoolSize(max(1, workers))
 
-  if argi == 0:
-    echo "usage: sphincs_sign [SECRET_KEY] [FILE]"
+      let nodes = manifest.findAll("file")
+      var
+        results = newSeq[XmlNode](nodes.len)
+        pending = newSeq[FlowVar[string]](nodes.len)
+        latencies = cast[ptr UncheckedArray[int64]](
+          allocShared0(max(1, nodes.len) * sizeof(int64)))
+      defer: deallocShared(latencies)
+
+      for i, x in nodes.pairs:
+        let path = x.attr("path")
+        try:
+          let digest = hashFile(path)
+          results[i] = <>file(path=path, digest=digest.hexDigest)
+          if previous.getOrDefault(path) == digest.hexDigest and
+              existsFile(path & ".sphincs"):
+            results[i].attrs["status"] = "skipped"
+          else:
+            pending[i] = spawn signDigest(pair, digest, latencies[i].addr)
+        except:
+          results[i] = <>file(path=path, status="failed",
+                              reason=getCurrentExceptionMsg())
+
+      var
+        signed, skipped, failed: int
+        latencySum, latencyMax: int64
+      for i, x in results.pairs:
+        if not pending[i].isNil:
+          let path = x.attr("path")
+          try:
+            writeFile(path & ".sphincs", ^pending[i])
+            x.attrs["status"] = "signed"
+            x.attrs["latency_us"] = $latencies[i]
+            latencySum += latencies[i]
+            latencyMax = max(latencyMax, latencies[i])
+          except:
+            x.attrs["status"] = "failed"
+            x.attrs["reason"] = getCurrentExceptionMsg()
+        case x.attr("status")
+        of "signed": inc signed
+        of "skipped": inc skipped
+        else: inc failed
+
+      let elapsed = epochTime() - start
+      report.submit do (s: Stream):
+        let xml = <>signatures(
+          files = $nodes.len, signed = $signed,
+          skipped = $skipped, failed = $failed,
+          workers = $max(1, workers),
+          elapsed_ms = $int(elapsed * 1000),
+          files_per_s = $int(if elapsed > 0: float(signed) / elapsed else: 0.0),
+          latency_avg_us = $(if signed > 0: latencySum div signed else: 0),
+          latency_max_us = $latencyMax)
+        for r in results.items:
+          xml.add(r)
+        s.writeLine(xml)
+
+    let
+      configHandler = env.newRomHandler("config", handleConfig)
+
+    process configHandler
+
+else:
+
+  proc main() =
+
+    var
+      pair: KeyPair
+      argi = 0
+    for kind, key, val in getopt():
+      if kind != cmdArgument:
+        quit("invalid argument " & key & val)
+      if argi == 0:
+        pair = readPair(key)
+      else:
+        signPath(pair, key)
+      inc argi
+
+    if argi == 0:
+      echo "usage: sphincs_sign [SECRET_KEY] [FILE]"
 
-main()
+  main()
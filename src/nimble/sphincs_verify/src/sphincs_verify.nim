@@ -1,19 +1,26 @@
-import std/xmltree, std/xmlparser, std/streams
+import std/xmltree, std/xmlparser, std/streams, std/tables, std/threadpool
 import sphincs/shake256_192f
 import nimcrypto.hash, nimcrypto/keccak
 
+const hashBufferSize = 1 shl 16
+  ## Files are hashed in chunks of this size to keep the
+  ## number of VFS round-trips low for large artifacts.
+
 proc hashFile(path: string): string =
-  let fs = openFileStream(path, fmRead)
+  var f: File
+  if not open(f, path, fmRead):
+    raise newException(IOError, "cannot open: " & path)
+  defer: close f
   result = newString(32)
   var
     ctx: sha3_256
-    buf: array[512, byte]
+    buf = newSeq[byte](hashBufferSize)
   let bp = addr buf[0]
   init ctx
-  while not fs.atEnd:
-    let n = fs.readData(bp, buf.len)
+  while true:
+    let n = f.readBuffer(bp, buf.len)
+    if n <= 0: break
     ctx.update(bp, n.uint)
-  close fs
   var d = finish ctx
   copyMem(result[0].addr, d.data[0].addr, result.len)
 
@@ -24,24 +31,35 @@ proc readPk(path: string): Pk =
   if fs.readData(result.addr, sizeof(result)) != sizeof(result):
     raiseAssert("malformed public key")
 
-proc verify(filePath, pkPath: string): XmlNode =
+type PkEntry = object
+  pk: Pk
+  error: string ## reason why the key is unusable, empty if valid
+
+proc lookupPk(cache: var Table[string, PkEntry]; path: string): PkEntry =
+  ## Parse each public key only once per batch of entries.
+  if not cache.hasKey(path):
+    var entry: PkEntry
+    try: entry.pk = readPk(path)
+    except: entry.error = getCurrentExceptionMsg()
+    cache[path] = entry
+  cache[path]
+
+proc verify(filePath: string; pk: Pk): string =
+  ## Verify a file against its signature, return the reason
+  ## of failure or an empty string if the file is good.
   try:
     let
-      pk = readPk(pkPath)
       sig = readFile(filePath & ".sphincs")
     let
       (valid, msg) = pk.verify sig
     if not valid:
-      result = <>bad(path=filePath, reason="bad signature")
+      result = "bad signature"
     else:
       let digest = hashFile(filePath)
-      if digest == msg:
-        result = <>good(path=filePath)
-      else:
-        result = <>bad(path=filePath, reason="file digest mismatch")
+      if digest != msg:
+        result = "file digest mismatch"
   except:
-    let e = getCurrentException()
-    result = <>bad(path=filePath, reason=e.msg)
+    result = getCurrentExceptionMsg()
 
 when defined(genode):
   import genode/reports, genode/roms
@@ -55,10 +73,26 @@ when defined(genode):
     let report = env.newReportClient("result")
 
     proc handleConfig(rom: RomClient) =
+      ## Entries are verified in parallel on the thread pool,
+      ## the results are reported in the order of the config.
       let nodes = rom.xml.findAll("verify")
-      var results = newSeq[XmlNode](nodes.len)
+      var
+        keys = initTable[string, PkEntry]()
+        pending = newSeq[FlowVar[string]](nodes.len)
+        results = newSeq[XmlNode](nodes.len)
+      for i, x in nodes.pairs:
+        let key = keys.lookupPk(x.attr("pubkey"))
+        if key.error.len > 0:
+          results[i] = <>bad(path=x.attr("path"), reason=key.error)
+        else:
+          pending[i] = spawn verify(x.attr("path"), key.pk)
+
       for i, x in nodes.pairs:
-        results[i] = verify(x.attr("path"), x.attr("pubkey"))
+        if results[i].isNil:
+          let reason = ^pending[i]
+          results[i] =
+            if reason.len == 0: <>good(path=x.attr("path"))
+            else: <>bad(path=x.attr("path"), reason=reason)
 
       report.submit do (s: Stream):
         let xml = <>result()
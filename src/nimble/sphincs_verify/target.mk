@@ -1,3 +1,6 @@
 include $(call select_from_repositories,mk/nimble.mk)
 
 LIBS += base libc
+
+# verification is spread over the thread pool
+NIM_OPT = --threads:on
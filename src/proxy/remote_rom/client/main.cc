@@ -8,6 +8,11 @@
  * | server | -> | remote_rom | -> (network) -> | remote_rom | -> | client |
  * |        |    |   server   |                 |   client   |    |        |
  * ----------    --------------                 --------------    ----------
+ *
+ * Each received version of a module is kept as a reference-counted
+ * snapshot. Sessions keep the snapshot they obtained until they ask for
+ * the dataspace again, so a commit never pulls the dataspace from under
+ * a reader and new readers get the latest version right away.
  */
 
 /*
@@ -20,6 +25,7 @@
 #include <base/env.h>
 #include <base/heap.h>
 #include <base/log.h>
+#include <base/session_label.h>
 #include <util/reconstructible.h>
 #include <util/list.h>
 
@@ -29,6 +35,8 @@
 #include <base/attached_ram_dataspace.h>
 #include <base/attached_rom_dataspace.h>
 #include <rom_session/rom_session.h>
+#include <os/reporter.h>
+#include <timer_session/connection.h>
 
 #include <base/component.h>
 
@@ -37,88 +45,243 @@
 
 namespace Remote_rom {
 	using Genode::size_t;
+	using Genode::uint64_t;
 	using Genode::Attached_ram_dataspace;
 	using Genode::Rom_dataspace_capability;
 	using Genode::Signal_context_capability;
 
+	struct Snapshot;
 	class  Session_component;
 	class  Root;
 	struct Main;
-	struct Rom_module;
+	class  Rom_module;
 
 	typedef Genode::List_element<Session_component> Session_element;
 	typedef Genode::List<Session_element>           Session_list;
+	typedef Genode::List<Rom_module>                Rom_module_list;
+};
+
+
+/**
+ * Version of the ROM data received from the remote server
+ */
+struct Remote_rom::Snapshot : Genode::List<Snapshot>::Element
+{
+	Attached_ram_dataspace ds;
+	unsigned long const    version;
+	unsigned               refs { 0 };
+
+	Snapshot(Genode::Ram_allocator &ram, Genode::Region_map &rm,
+	         unsigned long version)
+	: ds(ram, rm, 0), version(version) { }
+
+	Rom_dataspace_capability cap() const
+	{
+		using namespace Genode;
+
+		Dataspace_capability ds_cap = ds.cap();
+		return static_cap_cast<Rom_dataspace>(ds_cap);
+	}
 };
 
 
 /**
- * Interface used by the sessions to obtain the ROM data received from the
- * remote server
+ * ROM module received from the remote server
+ *
+ * The module receives into a background dataspace. On commit, the
+ * dataspace becomes the current snapshot. Older snapshots are freed once
+ * the last session referring to them has moved on.
  */
-class Remote_rom::Rom_module
+class Remote_rom::Rom_module : public Rom_receiver_base,
+                               public Genode::List<Rom_module>::Element
 {
+	public:
+
+		typedef Genode::String<64> Name;
+
 	private:
-		Genode::Ram_allocator &_ram;
-		Attached_ram_dataspace _fg; /* dataspace delivered to clients */
+
+		Genode::Env           &_env;
+		Genode::Allocator     &_alloc;
+		Timer::Connection     &_timer;
+		Name             const _name;
+
 		Attached_ram_dataspace _bg; /* dataspace for receiving data */
 
-		unsigned _bg_hash { 0 };
-		size_t   _bg_size { 0 };
+		unsigned _bg_hash   { 0 };
+		size_t   _bg_size   { 0 };
+		bool     _receiving { false };
+
+		Genode::List<Snapshot> _snapshots { };
+		Snapshot              *_current   { nullptr };
+		unsigned long          _version   { 0 };
+
+		Session_list _sessions { };
+
+		struct Stats
+		{
+			unsigned long updates = 0;
+			unsigned long errors  = 0;
+			uint64_t      start_us   = 0;   /* begin of current transfer */
+			uint64_t      latency_us = 0;   /* of the last update */
+			uint64_t      sum_us     = 0;
+			uint64_t      max_us     = 0;
+		} _stats { };
+
+		uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+		void _destroy(Snapshot &snapshot)
+		{
+			_snapshots.remove(&snapshot);
+
+			/* keep the larger buffer for receiving, unless in use */
+			if (!_receiving && _bg.size() < snapshot.ds.size())
+				_bg.swap(snapshot.ds);
+
+			Genode::destroy(_alloc, &snapshot);
+		}
+
+		void _notify_sessions();
+
+		/* Noncopyable */
+		Rom_module(Rom_module const &);
+		Rom_module &operator=(Rom_module const &);
 
 	public:
-		Rom_module(Genode::Ram_allocator &ram, Genode::Env &env)
-		: _ram(ram),
-		  _fg(_ram, env.rm(), 0),
-		  _bg(_ram, env.rm(), 4096)
+
+		Rom_module(Genode::Env &env, Genode::Allocator &alloc,
+		           Timer::Connection &timer, Name const &name)
+		: _env(env), _alloc(alloc), _timer(timer), _name(name),
+		  _bg(_env.ram(), _env.rm(), 4096)
 		{ }
 
-		Rom_dataspace_capability fg_dataspace() const
+		~Rom_module()
 		{
-			using namespace Genode;
+			while (Snapshot *s = _snapshots.first()) {
+				_snapshots.remove(s);
+				Genode::destroy(_alloc, s);
+			}
+		}
+
+		Name const &name() const { return _name; }
 
-			if (!_fg.size())
-				return Rom_dataspace_capability();
+		Session_list &sessions() { return _sessions; }
 
-			Dataspace_capability ds_cap = _fg.cap();
-			return static_cap_cast<Rom_dataspace>(ds_cap);
+		/**
+		 * Obtain reference to the current snapshot
+		 *
+		 * \return  nullptr if no content was received yet
+		 */
+		Snapshot *acquire()
+		{
+			if (_current)
+				_current->refs++;
+
+			return _current;
 		}
 
+		void release(Snapshot *snapshot)
+		{
+			if (!snapshot || --snapshot->refs || snapshot == _current)
+				return;
+
+			_destroy(*snapshot);
+		}
+
+		bool current(Snapshot const *snapshot) const {
+			return snapshot && snapshot == _current; }
+
+		void report(Genode::Xml_generator &xml) const
+		{
+			xml.node("module", [&] () {
+				xml.attribute("name",    _name);
+				xml.attribute("version", _version);
+				xml.attribute("updates", _stats.updates);
+				xml.attribute("errors",  _stats.errors);
+
+				unsigned snapshots = 0, readers = 0;
+				for (Snapshot const *s = _snapshots.first(); s; s = s->next()) {
+					++snapshots;
+					readers += s->refs;
+				}
+				xml.attribute("snapshots", snapshots);
+				xml.attribute("readers",   readers);
+
+				xml.attribute("latency_us",     _stats.latency_us);
+				xml.attribute("avg_latency_us", _stats.updates
+				                                ? _stats.sum_us/_stats.updates : 0);
+				xml.attribute("max_latency_us", _stats.max_us);
+			});
+		}
+
+
+		/***********************
+		 ** Rom_receiver_base **
+		 ***********************/
+
+		const char* module_name()  const override { return _name.string(); }
+		unsigned    content_hash() const override { return _bg_hash; }
+
 		/**
 		 * Return pointer to buffer that is ready to be filled with data.
 		 *
 		 * Data is written into the background dataspace.
-		 * Once it is ready, the 'commit_bg()' function is called.
+		 * Once it is ready, the 'commit_new_content()' function is called.
 		 */
-		char* base(size_t size)
+		char* start_new_content(unsigned hash, size_t size) override
 		{
+			/* save expected hash */
+			/* TODO (optional) skip if we already have the same data */
+			_bg_hash = hash;
+
 			/* let background buffer grow if needed */
 			if (_bg.size() < size)
-				_bg.realloc(&_ram, size);
+				_bg.realloc(&_env.ram(), size);
+
+			_bg_size   = size;
+			_receiving = true;
+			_stats.start_us = _now_us();
 
-			_bg_size = size;
 			return _bg.local_addr<char>();
 		}
 
 		/**
-		 * Commit data contained in background dataspace
-		 * (swap foreground and background dataspace)
+		 * Turn data contained in background dataspace into a new snapshot
 		 */
-		bool commit_bg()
+		void commit_new_content(bool abort=false) override
 		{
+			_receiving = false;
+
+			if (abort)
+				return;
+
 			if (_bg_hash != cksum(_bg.local_addr<char>(), _bg_size)) {
 				Genode::error("checksum error");
-				return false;
+				++_stats.errors;
+				return;
 			}
 
-			_fg.swap(_bg);
-			return true;
-		}
+			Snapshot &snapshot = *new (_alloc)
+				Snapshot(_env.ram(), _env.rm(), ++_version);
+			snapshot.ds.swap(_bg);
+			_snapshots.insert(&snapshot);
 
-		unsigned hash() const { return _bg_hash; }
-		void hash(unsigned v) { _bg_hash = v; }
+			Snapshot *old = _current;
+			_current = &snapshot;
+			if (old && !old->refs)
+				_destroy(*old);
 
+			uint64_t const latency_us = _now_us() - _stats.start_us;
+			++_stats.updates;
+			_stats.latency_us = latency_us;
+			_stats.sum_us    += latency_us;
+			_stats.max_us     = Genode::max(_stats.max_us, latency_us);
+
+			_notify_sessions();
+		}
 };
 
+
 class Remote_rom::Session_component :
   public Genode::Rpc_object<Genode::Rom_session, Session_component>
 {
@@ -127,24 +290,31 @@ class Remote_rom::Session_component :
 
 		Signal_context_capability _sigh;
 
-		Rom_module const &_rom_module;
+		Rom_module &_rom_module;
+		Snapshot   *_snapshot { nullptr };  /* snapshot handed out last */
 
-		Session_list &_sessions;
 		Session_element _element;
 
+		/* Noncopyable */
+		Session_component(Session_component const &);
+		Session_component &operator=(Session_component const &);
+
 	public:
 
 		static int version() { return 1; }
 
-		Session_component(Genode::Env &env, Session_list &sessions,
-		                  Rom_module const &rom_module)
+		Session_component(Genode::Env &env, Rom_module &rom_module)
 		:
-		  _env(env), _sigh(), _rom_module(rom_module), _sessions(sessions), _element(this)
+		  _env(env), _sigh(), _rom_module(rom_module), _element(this)
 		{
-			_sessions.insert(&_element);
+			_rom_module.sessions().insert(&_element);
 		}
 
-		~Session_component() { _sessions.remove(&_element); }
+		~Session_component()
+		{
+			_rom_module.sessions().remove(&_element);
+			_rom_module.release(_snapshot);
+		}
 
 		void notify_client()
 		{
@@ -158,105 +328,143 @@ class Remote_rom::Session_component :
 
 		Genode::Rom_dataspace_capability dataspace() override
 		{
-			return _rom_module.fg_dataspace();
+			Snapshot *snapshot = _rom_module.acquire();
+			_rom_module.release(_snapshot);
+			_snapshot = snapshot;
+
+			return _snapshot ? _snapshot->cap() : Rom_dataspace_capability();
 		}
-		
+
+		/**
+		 * The dataspace stays valid if no newer snapshot exists
+		 */
+		bool update() override { return _rom_module.current(_snapshot); }
+
 		void sigh(Genode::Signal_context_capability sigh) override
 		{
 			_sigh = sigh;
 		}
 };
 
+
+void Remote_rom::Rom_module::_notify_sessions()
+{
+	for (Session_element *s = _sessions.first(); s; s = s->next())
+		s->object()->notify_client();
+}
+
+
 class Remote_rom::Root : public Genode::Root_component<Session_component>
 {
 	private:
 
-		Genode::Env    &_env;
-		Rom_module     &_rom_module;
-		Session_list    _sessions;
+		Genode::Env     &_env;
+		Rom_module_list &_rom_modules;
 
 	protected:
 
-		Session_component *_create_session(const char *) override
+		Session_component *_create_session(const char *args) override
 		{
 			using namespace Genode;
 
-			/*
-			 * TODO compare requested module name with provided module name (config)
-			 * */
+			Session_label const label = label_from_args(args);
+			Rom_module::Name const name = label.last_element();
+
+			/* a single module is served regardless of the requested name */
+			Rom_module *module = _rom_modules.first();
+			if (module && module->next()) {
+				for (; module; module = module->next())
+					if (module->name() == name)
+						break;
+			}
+
+			if (!module) {
+				error("no remote ROM module for '", label, "'");
+				throw Service_denied();
+			}
 
 			return new (Root::md_alloc())
-			            Session_component(_env, _sessions, _rom_module);
+			            Session_component(_env, *module);
 		}
 
 	public:
 
-		Root(Genode::Env &env, Genode::Allocator &md_alloc, Rom_module &rom_module)
+		Root(Genode::Env &env, Genode::Allocator &md_alloc,
+		     Rom_module_list &rom_modules)
 		:
 		  Genode::Root_component<Session_component>(&env.ep().rpc_ep(), &md_alloc),
 		  _env(env),
-		  _rom_module(rom_module),
-		  _sessions()
+		  _rom_modules(rom_modules)
 		{ }
-
-		void notify_clients()
-		{
-			for (Session_element *s = _sessions.first(); s; s = s->next())
-				s->object()->notify_client();
-		}
 };
 
-struct Remote_rom::Main : public Rom_receiver_base
+struct Remote_rom::Main
 {
 	Genode::Env &env;
 	Genode::Heap heap            { &env.ram(), &env.rm() };
-	Rom_module   rom_module      { env.ram(), env };
-	Root         remote_rom_root { env, heap, rom_module };
 
 	Genode::Attached_rom_dataspace _config = { env, "config" };
 
-	Backend_client_base &_backend;
+	Timer::Connection _timer { env };
 
-	char remotename[255];
+	Rom_module_list rom_modules { };
+	Root            remote_rom_root { env, heap, rom_modules };
 
-	Main(Genode::Env &env) :
-	  env(env),
-	  _backend(backend_init_client(env, heap, _config.xml()))
-	{
-		try {
-			Genode::Xml_node remote_rom = _config.xml().sub_node("remote_rom");
-			remote_rom.attribute("name").value(remotename, sizeof(remotename));
-		} catch (...) {
-			Genode::error("No ROM module configured!");
-		}
+	Backend_client_base &_backend;
 
-		env.parent().announce(env.ep().manage(remote_rom_root));
+	Genode::Constructible<Genode::Expanding_reporter> _reporter { };
 
-		/* initialise backend */
-		_backend.register_receiver(this);
+	void _report(Genode::Duration)
+	{
+		_reporter->generate([&] (Genode::Xml_generator &xml) {
+			for (Rom_module *m = rom_modules.first(); m; m = m->next())
+				m->report(xml);
+		});
 	}
 
-	const char* module_name()  const override { return remotename; }
-	unsigned    content_hash() const override { return rom_module.hash(); }
+	Genode::Constructible<Timer::Periodic_timeout<Main>> _report_timeout { };
 
-	char* start_new_content(unsigned hash, size_t len) override
+	void _add_module(Rom_module::Name const &name)
 	{
-		/* save expected hash */
-		/* TODO (optional) skip if we already have the same data */
-		rom_module.hash(hash);
+		if (!name.valid())
+			return;
 
-		return rom_module.base(len);
+		Rom_module *module = new (heap) Rom_module(env, heap, _timer, name);
+		rom_modules.insert(module);
+
+		/* initialise backend */
+		_backend.register_receiver(module);
 	}
 
-	void commit_new_content(bool abort=false) override
+	Main(Genode::Env &env) :
+	  env(env),
+	  _backend(backend_init_client(env, heap, _config.xml()))
 	{
-		if (abort)
-			return;
+		using namespace Genode;
 
-		if (rom_module.commit_bg())
-			remote_rom_root.notify_clients();
-	}
+		try {
+			Xml_node remote_rom = _config.xml().sub_node("remote_rom");
+
+			_add_module(remote_rom.attribute_value("name", Rom_module::Name()));
+
+			remote_rom.for_each_sub_node("module", [&] (Xml_node module) {
+				_add_module(module.attribute_value("name", Rom_module::Name())); });
+		} catch (...) { }
 
+		if (!rom_modules.first())
+			error("No ROM module configured!");
+
+		try {
+			Xml_node report = _config.xml().sub_node("report");
+			if (report.attribute_value("latency", false)) {
+				_reporter.construct(env, "remote_rom", "remote_rom");
+				_report_timeout.construct(_timer, *this, &Main::_report,
+					Microseconds(report.attribute_value("period_ms", 1000U)*1000));
+			}
+		} catch (...) { }
+
+		env.parent().announce(env.ep().manage(remote_rom_root));
+	}
 };
 
 namespace Component {
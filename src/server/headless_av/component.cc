@@ -0,0 +1,407 @@
+/*
+ * \brief  Headless stand-in for Nitpicker and Audio_out
+ * \author agent
+ * \date   2026-10-19
+ *
+ * The component lets SDL programs run without display and audio hardware
+ * and measures what they produce. Framebuffer refreshes are accounted as
+ * frames, audio packets are consumed at the pace of a real sound card.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <audio_out_session/rpc_object.h>
+#include <base/attached_ram_dataspace.h>
+#include <base/attached_rom_dataspace.h>
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/registry.h>
+#include <framebuffer_session/framebuffer_session.h>
+#include <input/component.h>
+#include <nitpicker_session/nitpicker_session.h>
+#include <os/reporter.h>
+#include <root/component.h>
+#include <timer_session/connection.h>
+#include <util/reconstructible.h>
+
+namespace Headless_av {
+
+	using namespace Genode;
+
+	struct Frame_stats;
+	struct Framebuffer_session;
+	struct Nitpicker_session;
+	struct Nitpicker_root;
+	struct Audio_session;
+	struct Audio_root;
+	struct Main;
+
+	typedef Root_component<Nitpicker_session, Single_client> Nitpicker_root_base;
+}
+
+
+/**
+ * Frame count and frame-time histogram
+ */
+struct Headless_av::Frame_stats
+{
+	/*
+	 * A frame may be refreshed in several pieces, refreshes closer than
+	 * FRAME_GAP_US to the first refresh of a frame belong to this frame.
+	 */
+	enum {
+		FRAME_GAP_US = 500,
+		BUCKET_US    = 100,
+		NUM_BUCKETS  = 2048,   /* frame times up to 204.8 ms */
+	};
+
+	unsigned long frames         = 0;
+	uint64_t      first_us       = 0;
+	uint64_t      frame_start_us = 0;   /* first refresh of the current frame */
+	uint64_t      last_us        = 0;
+	uint64_t      max_us         = 0;
+
+	unsigned long buckets[NUM_BUCKETS] { };
+
+	void refresh(uint64_t now_us)
+	{
+		if (frames && now_us - frame_start_us < FRAME_GAP_US) {
+			last_us = now_us;
+			return;
+		}
+
+		if (frames) {
+			uint64_t const frame_us = now_us - frame_start_us;
+			buckets[min(frame_us / BUCKET_US, (uint64_t)NUM_BUCKETS - 1)]++;
+			max_us = max(max_us, frame_us);
+		} else {
+			first_us = now_us;
+		}
+
+		++frames;
+		frame_start_us = last_us = now_us;
+	}
+
+	/**
+	 * Frame time in microseconds below which 'percent' of the frames lie
+	 */
+	uint64_t percentile(unsigned percent) const
+	{
+		unsigned long const total = frames > 1 ? frames - 1 : 0;
+		if (!total) return 0;
+
+		unsigned long const limit = (total*percent + 99)/100;
+		unsigned long count = 0;
+		for (unsigned i = 0; i < NUM_BUCKETS; i++) {
+			count += buckets[i];
+			if (count >= limit)
+				return (uint64_t)(i + 1)*BUCKET_US;
+		}
+		return max_us;
+	}
+
+	/**
+	 * Average frames per second in hundredths
+	 */
+	uint64_t fps_x100() const
+	{
+		uint64_t const us = frame_start_us - first_us;
+		return us ? ((uint64_t)(frames - 1)*100*1000*1000)/us : 0;
+	}
+
+	void generate(Xml_generator &xml) const
+	{
+		uint64_t const fps = fps_x100();
+
+		xml.attribute("frames", frames);
+		xml.attribute("duration_ms", (last_us - first_us)/1000);
+		xml.attribute("fps", String<16>(fps/100, ".", fps%100 < 10 ? "0" : "", fps%100));
+		xml.attribute("p50_us", percentile(50));
+		xml.attribute("p90_us", percentile(90));
+		xml.attribute("p99_us", percentile(99));
+		xml.attribute("max_us", max_us);
+	}
+};
+
+
+/**
+ * Framebuffer backed by RAM, the content is never shown
+ */
+struct Headless_av::Framebuffer_session : Rpc_object<Framebuffer::Session>
+{
+	Env               &_env;
+	Timer::Connection &_timer;
+	Frame_stats       &_stats;
+
+	Framebuffer::Mode _mode;
+
+	Constructible<Attached_ram_dataspace> _ds { };
+
+	Signal_context_capability _sync_sigh { };
+
+	Framebuffer_session(Env &env, Timer::Connection &timer,
+	                    Frame_stats &stats, Framebuffer::Mode mode)
+	: _env(env), _timer(timer), _stats(stats), _mode(mode) { }
+
+	void buffer(Framebuffer::Mode mode)
+	{
+		_mode = mode;
+		_ds.construct(_env.ram(), _env.rm(),
+		              _mode.width()*_mode.height()*_mode.bytes_per_pixel());
+	}
+
+	void sync()
+	{
+		if (_sync_sigh.valid())
+			Signal_transmitter(_sync_sigh).submit();
+	}
+
+	Dataspace_capability dataspace() override {
+		return _ds.constructed() ? _ds->cap() : Dataspace_capability(); }
+
+	Framebuffer::Mode mode() const override { return _mode; }
+
+	void mode_sigh(Signal_context_capability) override { }
+
+	void refresh(int, int, int, int) override {
+		_stats.refresh(_timer.curr_time().trunc_to_plain_us().value); }
+
+	void sync_sigh(Signal_context_capability sigh) override {
+		_sync_sigh = sigh; }
+};
+
+
+struct Headless_av::Nitpicker_session : Rpc_object<Nitpicker::Session>
+{
+	Env        &_env;
+	Entrypoint &_ep;
+
+	Framebuffer::Mode const _mode;
+
+	Framebuffer_session _framebuffer;
+
+	Input::Session_component _input { _env, _env.ram() };
+
+	typedef Nitpicker::Session::Command_buffer Command_buffer;
+	Attached_ram_dataspace _command_ds { _env.ram(), _env.rm(), sizeof(Command_buffer) };
+
+	Nitpicker_session(Env &env, Entrypoint &ep, Timer::Connection &timer,
+	                  Frame_stats &stats, Framebuffer::Mode mode)
+	:
+		_env(env), _ep(ep), _mode(mode),
+		_framebuffer(env, timer, stats, mode)
+	{
+		_ep.manage(_framebuffer);
+		_ep.manage(_input);
+		_input.event_queue().enabled(true);
+	}
+
+	~Nitpicker_session()
+	{
+		_ep.dissolve(_input);
+		_ep.dissolve(_framebuffer);
+	}
+
+	void sync() { _framebuffer.sync(); }
+
+	Framebuffer::Session_capability framebuffer_session() override {
+		return _framebuffer.cap(); }
+
+	Input::Session_capability input_session() override {
+		return _input.cap(); }
+
+	/* views are not displayed, so there is nothing to keep track of */
+	View_handle create_view(View_handle) override { return View_handle(); }
+
+	void destroy_view(View_handle) override { }
+
+	View_handle view_handle(View_capability, View_handle handle) override {
+		return handle; }
+
+	View_capability view_capability(View_handle) override {
+		return View_capability(); }
+
+	void release_view_handle(View_handle) override { }
+
+	Dataspace_capability command_dataspace() override {
+		return _command_ds.cap(); }
+
+	void execute() override { }
+
+	Framebuffer::Mode mode() override { return _mode; }
+
+	void mode_sigh(Signal_context_capability) override { }
+
+	void buffer(Framebuffer::Mode mode, bool) override {
+		_framebuffer.buffer(mode); }
+
+	void focus(Capability<Nitpicker::Session>) override { }
+};
+
+
+struct Headless_av::Nitpicker_root : Nitpicker_root_base
+{
+	/*
+	 * Noncopyable
+	 */
+	Nitpicker_root(Nitpicker_root const &);
+	Nitpicker_root &operator = (Nitpicker_root const &);
+
+	Env               &_env;
+	Timer::Connection &_timer;
+	Frame_stats       &_stats;
+	Framebuffer::Mode  _mode;
+
+	Nitpicker_session *_session = nullptr;
+
+	Nitpicker_session *_create_session(const char *) override
+	{
+		_session = new (md_alloc())
+			Nitpicker_session(_env, _env.ep(), _timer, _stats, _mode);
+		return _session;
+	}
+
+	void _destroy_session(Nitpicker_session *session) override
+	{
+		_session = nullptr;
+		Genode::destroy(md_alloc(), session);
+	}
+
+	Nitpicker_root(Env &env, Allocator &md_alloc, Timer::Connection &timer,
+	               Frame_stats &stats, Framebuffer::Mode mode)
+	:
+		Nitpicker_root_base(env.ep(), md_alloc),
+		_env(env), _timer(timer), _stats(stats), _mode(mode)
+	{ }
+
+	void sync() { if (_session) _session->sync(); }
+};
+
+
+/**
+ * Audio channel that plays to nowhere
+ */
+struct Headless_av::Audio_session : Audio_out::Session_rpc_object
+{
+	unsigned long &_played;
+	unsigned long &_underruns;
+
+	Audio_session(Env &env, unsigned long &played, unsigned long &underruns)
+	:
+		Audio_out::Session_rpc_object(env, Signal_context_capability()),
+		_played(played), _underruns(underruns)
+	{ }
+
+	/**
+	 * Consume one period, as a sound card would
+	 */
+	void play()
+	{
+		if (stopped()) return;
+
+		bool const full = stream()->full();
+
+		Audio_out::Packet *p = stream()->get(stream()->pos());
+		if (p->valid()) ++_played;
+		else            ++_underruns;
+
+		p->invalidate();
+		p->mark_as_played();
+		stream()->increment_position();
+
+		progress_submit();
+		if (full) alloc_submit();
+	}
+};
+
+
+struct Headless_av::Audio_root : Root_component<Audio_session, Multiple_clients>
+{
+	Env &_env;
+
+	Registry<Registered<Audio_session>> _sessions { };
+
+	unsigned long played = 0, underruns = 0;
+
+	Audio_session *_create_session(const char *) override
+	{
+		return new (md_alloc())
+			Registered<Audio_session>(_sessions, _env, played, underruns);
+	}
+
+	void _destroy_session(Audio_session *session) override {
+		Genode::destroy(md_alloc(), static_cast<Registered<Audio_session> *>(session)); }
+
+	Audio_root(Env &env, Allocator &md_alloc)
+	: Root_component<Audio_session, Multiple_clients>(env.ep(), md_alloc), _env(env) { }
+
+	void play() { _sessions.for_each([&] (Audio_session &s) { s.play(); }); }
+};
+
+
+struct Headless_av::Main
+{
+	Env &_env;
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Timer::Connection _timer { _env };
+
+	Sliced_heap _sliced_heap { _env.ram(), _env.rm() };
+
+	Frame_stats _frame_stats { };
+
+	Framebuffer::Mode const _mode {
+		(int)_config.xml().attribute_value("width",  640U),
+		(int)_config.xml().attribute_value("height", 480U),
+		Framebuffer::Mode::RGB565 };
+
+	Nitpicker_root _nitpicker_root {
+		_env, _sliced_heap, _timer, _frame_stats, _mode };
+
+	Audio_root _audio_root { _env, _sliced_heap };
+
+	Expanding_reporter _reporter { _env, "frames", "frames" };
+
+	void _report(Duration)
+	{
+		_reporter.generate([&] (Xml_generator &xml) {
+			_frame_stats.generate(xml);
+			xml.node("audio", [&] () {
+				xml.attribute("played",    _audio_root.played);
+				xml.attribute("underruns", _audio_root.underruns);
+			});
+		});
+	}
+
+	void _sync(Duration)  { _nitpicker_root.sync(); }
+	void _audio(Duration) { _audio_root.play(); }
+
+	Timer::Periodic_timeout<Main> _report_timeout {
+		_timer, *this, &Main::_report,
+		Microseconds(_config.xml().attribute_value("report_ms", 1000U)*1000) };
+
+	Timer::Periodic_timeout<Main> _sync_timeout {
+		_timer, *this, &Main::_sync,
+		Microseconds(1000*1000/max(1U, _config.xml().attribute_value("sync_hz", 60U))) };
+
+	/* one period of Audio_out::PERIOD samples */
+	Timer::Periodic_timeout<Main> _audio_timeout {
+		_timer, *this, &Main::_audio,
+		Microseconds((uint64_t)Audio_out::PERIOD*1000*1000/Audio_out::SAMPLE_RATE) };
+
+	Main(Env &env) : _env(env)
+	{
+		_env.parent().announce(_env.ep().manage(_nitpicker_root));
+		_env.parent().announce(_env.ep().manage(_audio_root));
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Headless_av::Main main(env); }
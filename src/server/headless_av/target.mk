@@ -0,0 +1,3 @@
+TARGET = headless_av
+SRC_CC = component.cc
+LIBS   = base
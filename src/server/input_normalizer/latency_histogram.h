@@ -0,0 +1,76 @@
+/*
+ * \brief  Histogram of event-forwarding latencies
+ * \author agent
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INPUT_NORMALIZER__LATENCY_HISTOGRAM_H_
+#define _INPUT_NORMALIZER__LATENCY_HISTOGRAM_H_
+
+/* Genode includes */
+#include <util/xml_generator.h>
+#include <base/stdint.h>
+
+namespace Input_normalizer { struct Latency_histogram; }
+
+
+/**
+ * Histogram with power-of-two bucket bounds
+ *
+ * Bucket 'i' counts latencies below '2^i * MIN_US' microseconds, the last
+ * bucket collects everything beyond.
+ */
+struct Input_normalizer::Latency_histogram
+{
+	enum { MIN_US = 125, NUM_BUCKETS = 16 };
+
+	Genode::uint64_t _buckets[NUM_BUCKETS] { };
+	Genode::uint64_t _count  = 0;
+	Genode::uint64_t _sum_us = 0;
+	Genode::uint64_t _max_us = 0;
+
+	static unsigned _bucket(Genode::uint64_t us)
+	{
+		unsigned i = 0;
+		for (Genode::uint64_t bound = MIN_US;
+		     i < NUM_BUCKETS - 1 && us >= bound; bound <<= 1)
+			++i;
+		return i;
+	}
+
+	void record(Genode::uint64_t us)
+	{
+		++_buckets[_bucket(us)];
+		++_count;
+		_sum_us += us;
+		if (us > _max_us) _max_us = us;
+	}
+
+	void generate(Genode::Xml_generator &xml) const
+	{
+		xml.attribute("count",  _count);
+		xml.attribute("avg_us", _count ? _sum_us / _count : 0);
+		xml.attribute("max_us", _max_us);
+
+		for (unsigned i = 0; i < NUM_BUCKETS; ++i) {
+			if (!_buckets[i]) continue;
+
+			xml.node("bucket", [&] () {
+				if (i < NUM_BUCKETS - 1)
+					xml.attribute("below_us", (Genode::uint64_t)MIN_US << i);
+				else
+					xml.attribute("above_us", (Genode::uint64_t)MIN_US << (i - 1));
+				xml.attribute("count", _buckets[i]);
+			});
+		}
+	}
+};
+
+#endif /* _INPUT_NORMALIZER__LATENCY_HISTOGRAM_H_ */
@@ -21,6 +21,10 @@
 #include <base/component.h>
 #include <base/attached_rom_dataspace.h>
 #include <base/attached_dataspace.h>
+#include <os/reporter.h>
+
+/* local includes */
+#include <latency_histogram.h>
 
 namespace Input_normalizer {
 	using namespace Genode;
@@ -35,20 +39,33 @@ struct Input_normalizer::Main
 {
 	Genode::Env &env;
 
-	unsigned config_period_ms()
+	unsigned config_ms(char const *attr, unsigned default_value)
 	{
-		enum { DEFAULT_PERIOD_MS = 200 };
-		unsigned value = DEFAULT_PERIOD_MS;
+		unsigned value = default_value;
 
 		try {
 			Attached_rom_dataspace config { env, "config" };
-			config.xml().attribute("period_ms").value(&value);
+			config.xml().attribute(attr).value(&value);
 		} catch (...) { }
 		return value;
 	}
 
+	enum {
+		DEFAULT_PERIOD_MS   = 200,
+		DEFAULT_COALESCE_MS = 0,
+		DEFAULT_REPORT_MS   = 0,
+	};
+
 	Microseconds const period_us =
-		Microseconds{config_period_ms() * 1000};
+		Microseconds{config_ms("period_ms", DEFAULT_PERIOD_MS) * 1000};
+
+	/* window for merging motion events, zero disables coalescing */
+	Microseconds const coalesce_us =
+		Microseconds{config_ms("coalesce_ms", DEFAULT_COALESCE_MS) * 1000};
+
+	/* interval of the latency report, zero disables reporting */
+	Microseconds const report_us =
+		Microseconds{config_ms("report_ms", DEFAULT_REPORT_MS) * 1000};
 
 	/* input session provided by our parent  */
 	Input::Connection parent_input { env };
@@ -65,11 +82,142 @@ struct Input_normalizer::Main
 	/* Timer session for delaying events */
 	Timer::Connection timer { env };
 
+	uint64_t now_us() { return timer.curr_time().trunc_to_plain_us().value; }
+
+
+	/*************************
+	 ** Latency measurement **
+	 *************************/
+
+	Latency_histogram latency { };
+
+	uint64_t events_in  = 0;
+	uint64_t events_out = 0;
+	uint64_t dropped    = 0;   /* latency samples not recorded */
+
+	/* arrival times of queued events not yet signalled downstream */
+	enum { MAX_PENDING = 256 };
+	uint64_t pending_arrival[MAX_PENDING] { };
+	unsigned num_pending = 0;
+
+	void add(Input::Event const &e, uint64_t arrival_us)
+	{
+		enum { SUBMIT_NOW = false };
+		queue.add(e, SUBMIT_NOW);
+
+		if (num_pending < MAX_PENDING)
+			pending_arrival[num_pending++] = arrival_us;
+		else
+			++dropped;
+		++events_out;
+	}
+
+	void submit()
+	{
+		queue.submit_signal();
+
+		uint64_t const now = now_us();
+		for (unsigned i = 0; i < num_pending; ++i)
+			latency.record(now - pending_arrival[i]);
+		num_pending = 0;
+	}
+
+	Constructible<Reporter> reporter { };
+
+	void handle_report(Duration)
+	{
+		if (!reporter.constructed())
+			return;
+
+		Reporter::Xml_generator xml(*reporter, [&] () {
+			xml.attribute("events_in",  events_in);
+			xml.attribute("events_out", events_out);
+			xml.attribute("dropped",    dropped);
+			xml.node("latency", [&] () { latency.generate(xml); });
+		});
+	}
+
+	Constructible<Timer::Periodic_timeout<Main>> report_timeout { };
+
+
+	/***********************
+	 ** Motion coalescing **
+	 ***********************/
+
+	struct Pending_motion
+	{
+		enum Type { NONE, RELATIVE, ABSOLUTE } type = NONE;
+
+		int      x = 0, y = 0;
+		uint64_t arrival_us = 0;
+	};
+
+	Pending_motion motion { };
+
+	/**
+	 * Move the merged motion into the client queue
+	 */
+	void flush_motion()
+	{
+		switch (motion.type) {
+		case Pending_motion::NONE:
+			return;
+		case Pending_motion::RELATIVE:
+			add(Input::Event(Input::Relative_motion{motion.x, motion.y}), motion.arrival_us);
+			break;
+		case Pending_motion::ABSOLUTE:
+			add(Input::Event(Input::Absolute_motion{motion.x, motion.y}), motion.arrival_us);
+			break;
+		}
+		motion = Pending_motion();
+	}
+
+	/**
+	 * Merge motion event into pending motion
+	 *
+	 * \return  false if the event is not a motion event
+	 */
+	bool coalesce(Input::Event const &e, uint64_t arrival_us)
+	{
+		bool merged = false;
+
+		auto merge = [&] (Pending_motion::Type type, int x, int y, bool accumulate)
+		{
+			if (motion.type != type) {
+				flush_motion();
+				motion.type       = type;
+				motion.arrival_us = arrival_us;
+			}
+			motion.x = accumulate ? motion.x + x : x;
+			motion.y = accumulate ? motion.y + y : y;
+			merged   = true;
+		};
+
+		e.handle_relative_motion([&] (int x, int y) {
+			merge(Pending_motion::RELATIVE, x, y, true); });
+
+		e.handle_absolute_motion([&] (int x, int y) {
+			merge(Pending_motion::ABSOLUTE, x, y, false); });
+
+		return merged;
+	}
+
+	void handle_coalesce_timeout(Duration)
+	{
+		flush_motion();
+		submit();
+		burst_timeout.discard();
+	}
+
+	Timer::One_shot_timeout<Main> coalesce_timeout =
+		{ timer, *this, &Main::handle_coalesce_timeout };
+
+
 	/* submit after delay */
 	void handle_timeout(Duration)
 	{
 		if (!queue.empty())
-			queue.submit_signal();
+			submit();
 	}
 
 	Timer::One_shot_timeout<Main> burst_timeout =
@@ -87,19 +235,38 @@ struct Input_normalizer::Main
 		 */
 		bool notify = false;
 
+		uint64_t const arrival_us = now_us();
+
 		parent_input.for_each_event([&] (Event const &e) {
+			++events_in;
+
+			if (coalesce_us.value) {
+				if (coalesce(e, arrival_us))
+					return;
+
+				/* preserve the order of motion and other events */
+				if (motion.type != Pending_motion::NONE) {
+					flush_motion();
+					notify = true;
+				}
+			}
+
 			if (!e.press() && !e.release())
 				notify = true;
-			enum { SUBMIT_NOW = false };
-			queue.add(e, SUBMIT_NOW);
+			add(e, arrival_us);
 		});
 
 		if (notify) {
-			queue.submit_signal();
+			submit();
 			burst_timeout.discard();
-		} else if (!burst_timeout.scheduled()) {
+			coalesce_timeout.discard();
+		} else if (!queue.empty() && !burst_timeout.scheduled()) {
 			burst_timeout.schedule(period_us);
 		}
+
+		/* deliver merged motion at the end of the window */
+		if (motion.type != Pending_motion::NONE && !coalesce_timeout.scheduled())
+			coalesce_timeout.schedule(coalesce_us);
 	}
 
 	Signal_handler<Main> input_handler =
@@ -112,6 +279,12 @@ struct Input_normalizer::Main
 	{
 		queue.enabled(true);
 
+		if (report_us.value) {
+			reporter.construct(env, "input_latency");
+			reporter->enabled(true);
+			report_timeout.construct(timer, *this, &Main::handle_report, report_us);
+		}
+
 		/* register input handler */
 		parent_input.sigh(input_handler);
 
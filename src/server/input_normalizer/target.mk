@@ -1,5 +1,6 @@
 TARGET = input_normalizer
 SRC_CC = main.cc
 LIBS   = base
+INC_DIR += $(PRG_DIR)
 
 CC_CXX_WARN_STRICT =
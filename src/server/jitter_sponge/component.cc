@@ -77,9 +77,8 @@ struct Jitter_sponge::Generator
 
 		if (Genode::Rdrand::supported()) {
 			enum { RDRAND_COUNT = 4 };
-			Genode::uint64_t buf[4];
-			for (unsigned i = 0; i < RDRAND_COUNT; i++)
-				buf[i] = Genode::Rdrand::random64();
+			Genode::uint64_t buf[RDRAND_COUNT];
+			Genode::Rdrand::fill(buf, sizeof(buf));
 			if (KeccakWidth1600_SpongePRG_Feed(&sponge, (unsigned char *)buf, sizeof(buf)))
 				die("failed to feed sponge");
 		} else {
@@ -26,9 +26,54 @@ static char const *_fs_name = "ext4";
 static char const *_fs_mp   = "/";
 static bool        _cache_write_back = false;
 
+static ext4_blockdev *_bd;
+
+
+/*
+ * The lwext4 block cache does not account its activity. The lookup and
+ * drop functions are wrapped at link time (see target.mk) to count hits,
+ * misses, and the blocks dropped by the block device when shaking the
+ * cache.
+ */
+
+static struct {
+	unsigned long hits      = 0;
+	unsigned long misses    = 0;
+	unsigned long evictions = 0;
+} _cache_stats;
+
+
+extern "C" int __real_ext4_bcache_alloc(struct ext4_bcache *,
+                                        struct ext4_block *, bool *);
+
+extern "C" int __wrap_ext4_bcache_alloc(struct ext4_bcache *bc,
+                                        struct ext4_block  *b,
+                                        bool               *is_new)
+{
+	int const err = __real_ext4_bcache_alloc(bc, b, is_new);
+	if (err == EOK) {
+		if (*is_new) { ++_cache_stats.misses; }
+		else         { ++_cache_stats.hits;   }
+	}
+	return err;
+}
+
+
+extern "C" void __real_ext4_bcache_drop_buf(struct ext4_bcache *,
+                                            struct ext4_buf *);
+
+extern "C" void __wrap_ext4_bcache_drop_buf(struct ext4_bcache *bc,
+                                            struct ext4_buf    *buf)
+{
+	++_cache_stats.evictions;
+	__real_ext4_bcache_drop_buf(bc, buf);
+}
+
 
 void File_system::init(ext4_blockdev *bd)
 {
+	_bd = bd;
+
 	int err = ext4_device_register(bd, _fs_name);
 	if (err) { throw Init_failed(); }
 }
@@ -98,7 +143,20 @@ void File_system::sync()
 }
 
 
-void File_system::stats_update(Genode::Reporter &reporter)
+unsigned File_system::dirty_blocks()
+{
+	struct ext4_bcache const *bc = _bd ? _bd->bc : nullptr;
+	if (!bc) { return 0; }
+
+	unsigned dirty = 0;
+	struct ext4_buf *buf;
+	SLIST_FOREACH(buf, &bc->dirty_list, dirty_node) { ++dirty; }
+
+	return dirty;
+}
+
+
+void File_system::stats_update(Genode::Xml_generator &xml)
 {
 	using namespace Genode;
 
@@ -109,17 +167,25 @@ void File_system::stats_update(Genode::Reporter &reporter)
 		return;
 	}
 
-	try {
-		Reporter::Xml_generator xml(reporter, [&] () {
-			xml.node("blocks", [&] () {
-				xml.attribute("used",  stats.blocks_count-stats.free_blocks_count);
-				xml.attribute("avail", stats.free_blocks_count);
-				xml.attribute("size",  stats.block_size);
-			});
-			xml.node("inodes", [&] () {
-				xml.attribute("used",  stats.inodes_count);
-				xml.attribute("avail", stats.free_inodes_count);
-			});
-		});
-	} catch (...) { }
+	xml.node("blocks", [&] () {
+		xml.attribute("used",  stats.blocks_count-stats.free_blocks_count);
+		xml.attribute("avail", stats.free_blocks_count);
+		xml.attribute("size",  stats.block_size);
+	});
+	xml.node("inodes", [&] () {
+		xml.attribute("used",  stats.inodes_count);
+		xml.attribute("avail", stats.free_inodes_count);
+	});
+
+	struct ext4_bcache const *bc = _bd ? _bd->bc : nullptr;
+	if (!bc) { return; }
+
+	xml.node("cache", [&] () {
+		xml.attribute("size",       bc->cnt);
+		xml.attribute("referenced", bc->ref_blocks);
+		xml.attribute("dirty",      dirty_blocks());
+		xml.attribute("hits",       _cache_stats.hits);
+		xml.attribute("misses",     _cache_stats.misses);
+		xml.attribute("evictions",  _cache_stats.evictions);
+	});
 }
@@ -15,7 +15,7 @@
 
 /* Genode includes */
 #include <base/exception.h>
-#include <os/reporter.h>
+#include <util/xml_generator.h>
 #include <util/xml_node.h>
 
 
@@ -32,7 +32,16 @@ namespace File_system {
 	void mount_fs(Genode::Xml_node);
 	void unmount_fs();
 	void sync();
-	void stats_update(Genode::Reporter &);
+
+	/**
+	 * Return number of modified blocks in the block cache
+	 */
+	unsigned dirty_blocks();
+
+	/**
+	 * Generate usage and block-cache statistics
+	 */
+	void stats_update(Genode::Xml_generator &);
 }
 
 #endif /* _FILE_SYSTEM_H_ */
@@ -0,0 +1,223 @@
+/*
+ * \brief  Lwext4 file system cache flusher
+ * \author agent
+ * \date   2026-10-19
+ *
+ * Sync requests are not served one by one. The flusher collects the
+ * requests of all sessions and writes the cache back once for the whole
+ * group, after which the sessions acknowledge their sync packets.
+ * Besides on sync, the cache is written back periodically and after a
+ * configurable amount of data was written.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _FLUSHER_H_
+#define _FLUSHER_H_
+
+/* Genode includes */
+#include <base/registry.h>
+#include <base/signal.h>
+#include <timer_session/connection.h>
+#include <util/reconstructible.h>
+#include <util/xml_generator.h>
+#include <util/xml_node.h>
+
+/* local includes */
+#include <file_system.h>
+
+namespace Lwext4_fs {
+	using namespace Genode;
+
+	struct Flusher;
+}
+
+
+struct Lwext4_fs::Flusher
+{
+	/**
+	 * Interface of sessions waiting for a flush
+	 */
+	struct Client : Interface
+	{
+		virtual void flushed(bool succeeded) = 0;
+	};
+
+	/**
+	 * Interface notified once per flush, after all clients
+	 */
+	struct Observer : Interface
+	{
+		virtual void flush_completed() = 0;
+	};
+
+	struct Stats
+	{
+		unsigned long flushes   = 0;
+		unsigned long syncs     = 0;   /* sync requests served */
+		unsigned long max_group = 0;   /* most syncs served by one flush */
+		unsigned long errors    = 0;
+
+		void generate(Xml_generator &xml) const
+		{
+			xml.node("flush", [&] () {
+				xml.attribute("flushes",   flushes);
+				xml.attribute("syncs",     syncs);
+				xml.attribute("max_group", max_group);
+				xml.attribute("errors",    errors);
+			});
+		}
+	};
+
+	Env &_env;
+
+	Registry<Client> clients { };
+
+	Stats stats { };
+
+	Observer *observer = nullptr;
+
+	bool mounted = false;
+
+	unsigned long _pending_syncs = 0;
+	size_t        _written       = 0;   /* since the last flush */
+	size_t        _threshold     = 0;
+
+	unsigned _delay_ms    = 0;
+	unsigned _interval_ms = 0;
+
+	bool _flush_submitted = false;
+
+	Signal_handler<Flusher> _flush_handler {
+		_env.ep(), *this, &Flusher::_handle_flush };
+
+	Constructible<Timer::Connection>                _timer            { };
+	Constructible<Timer::One_shot_timeout<Flusher>> _delay_timeout    { };
+	Constructible<Timer::Periodic_timeout<Flusher>> _interval_timeout { };
+
+	void _handle_flush()
+	{
+		_flush_submitted = false;
+		flush();
+	}
+
+	void _handle_delay(Duration) { flush(); }
+
+	void _handle_interval(Duration)
+	{
+		if (_pending_syncs || File_system::dirty_blocks())
+			flush();
+	}
+
+	/*
+	 * The flush is performed after the signals that are already pending,
+	 * so syncs of sessions served in the same round share one flush.
+	 */
+	void _submit_flush()
+	{
+		if (_flush_submitted) { return; }
+
+		_flush_submitted = true;
+		Signal_transmitter(_flush_handler).submit();
+	}
+
+	Flusher(Env &env) : _env(env) { }
+
+	/**
+	 * Configure from the '<flush>' node of the config
+	 */
+	void configure(Xml_node config)
+	{
+		unsigned delay_ms = 0, interval_ms = 0, threshold_kib = 0;
+		try {
+			Xml_node flush = config.sub_node("flush");
+			delay_ms      = flush.attribute_value("delay_ms",      0U);
+			interval_ms   = flush.attribute_value("interval_ms",   0U);
+			threshold_kib = flush.attribute_value("threshold_kib", 0U);
+		} catch (...) { }
+
+		_threshold = (size_t)threshold_kib * 1024;
+
+		if ((delay_ms || interval_ms) && !_timer.constructed())
+			_timer.construct(_env);
+
+		if (delay_ms != _delay_ms) {
+			_delay_timeout.destruct();
+			if (delay_ms)
+				_delay_timeout.construct(*_timer, *this, &Flusher::_handle_delay);
+			_delay_ms = delay_ms;
+		}
+
+		if (interval_ms != _interval_ms) {
+			_interval_timeout.destruct();
+			if (interval_ms)
+				_interval_timeout.construct(*_timer, *this, &Flusher::_handle_interval,
+				                            Microseconds(interval_ms*1000));
+			_interval_ms = interval_ms;
+		}
+	}
+
+	/**
+	 * Write back the cache and notify the waiting clients
+	 *
+	 * \return true on success
+	 */
+	bool flush()
+	{
+		if (_delay_timeout.constructed() && _delay_timeout->scheduled())
+			_delay_timeout->discard();
+
+		bool succeeded = true;
+		if (mounted) {
+			try         { File_system::sync(); }
+			catch (...) { succeeded = false; ++stats.errors; }
+
+			++stats.flushes;
+			stats.syncs    += _pending_syncs;
+			stats.max_group = max(stats.max_group, _pending_syncs);
+		}
+
+		_pending_syncs = 0;
+		_written       = 0;
+
+		clients.for_each([&] (Client &client) { client.flushed(succeeded); });
+
+		if (mounted && observer) { observer->flush_completed(); }
+
+		return succeeded;
+	}
+
+	/**
+	 * Request flush on behalf of a sync packet
+	 */
+	void sync()
+	{
+		++_pending_syncs;
+
+		if (_delay_timeout.constructed()) {
+			if (!_delay_timeout->scheduled())
+				_delay_timeout->schedule(Microseconds(_delay_ms*1000));
+			return;
+		}
+
+		_submit_flush();
+	}
+
+	/**
+	 * Account written data, flush once the threshold is exceeded
+	 */
+	void written(size_t bytes)
+	{
+		_written += bytes;
+
+		if (_threshold && _written >= _threshold)
+			_submit_flush();
+	}
+};
+
+#endif /* _FLUSHER_H_ */
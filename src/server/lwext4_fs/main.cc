@@ -28,6 +28,8 @@
 #include <directory.h>
 #include <file.h>
 #include <file_system.h>
+#include <flusher.h>
+#include <metrics.h>
 #include <open_node.h>
 #include <symlink.h>
 
@@ -41,7 +43,8 @@ namespace Lwext4_fs {
 	struct Session_component;
 }
 
-class Lwext4_fs::Session_component : public File_system::Session_rpc_object
+class Lwext4_fs::Session_component : public File_system::Session_rpc_object,
+                                     public Flusher::Client
 {
 	private:
 
@@ -56,12 +59,52 @@ class Lwext4_fs::Session_component : public File_system::Session_rpc_object
 
 		Signal_handler<Session_component> _process_packet_handler;
 
-		Genode::Reporter _stats_reporter { _env , "file_system_stats", "stats" };
+		Metrics                     &_metrics;
+		Metrics::Registered_session  _session_metrics;
+
+		Flusher                          &_flusher;
+		Registry<Flusher::Client>::Element _flusher_client { _flusher.clients, *this };
+
+		/*
+		 * Sync packets are acknowledged after the next flush. Flushed
+		 * syncs stay queued until the client is ready for their
+		 * acknowledgement, and no packets are taken from the client while
+		 * the queue is full.
+		 */
+		struct Pending_sync
+		{
+			Packet_descriptor packet   { };
+			uint64_t          start_us { 0 };
+			bool              flushed  { false };
+		};
+
+		enum { MAX_PENDING_SYNCS = File_system::Session::TX_QUEUE_SIZE };
+
+		Pending_sync _pending_syncs[MAX_PENDING_SYNCS];
+		unsigned     _num_pending_syncs { 0 };
 
 		/******************************
 		 ** Packet-stream processing **
 		 ******************************/
 
+		/**
+		 * Acknowledge flushed sync packets as far as the client allows
+		 */
+		void _ack_flushed_syncs()
+		{
+			unsigned acked = 0;
+			while (acked < _num_pending_syncs
+			    && _pending_syncs[acked].flushed
+			    && tx_sink()->ready_to_ack())
+				tx_sink()->acknowledge_packet(_pending_syncs[acked++].packet);
+
+			if (!acked) { return; }
+
+			for (unsigned i = acked; i < _num_pending_syncs; i++)
+				_pending_syncs[i - acked] = _pending_syncs[i];
+			_num_pending_syncs -= acked;
+		}
+
 		/**
 		 * Perform packet operation
 		 *
@@ -76,6 +119,8 @@ class Lwext4_fs::Session_component : public File_system::Session_rpc_object
 			size_t res_length = 0;
 			bool succeeded = false;
 
+			uint64_t const start_us = _metrics.now_us();
+
 			switch (packet.operation()) {
 
 			case Packet_descriptor::READ:
@@ -95,9 +140,12 @@ class Lwext4_fs::Session_component : public File_system::Session_rpc_object
 					if (res_length != length) {
 						Genode::error("partial write detected ",
 						              res_length, " vs ", length);
+						_session_metrics.record(packet.operation(), res_length, false,
+						                        _metrics.now_us() - start_us);
 						/* do not acknowledge */
 						return;
 					}
+					_flusher.written(res_length);
 					succeeded = true;
 				}
 				break;
@@ -115,15 +163,15 @@ class Lwext4_fs::Session_component : public File_system::Session_rpc_object
 				break;
 
 			case Packet_descriptor::SYNC:
-				/* for future failure handling */
-				try         { File_system::sync(); }
-				catch (...) { }
-
-				File_system::stats_update(_stats_reporter);
-				succeeded = true;
-				break;
+				_pending_syncs[_num_pending_syncs++] = { packet, start_us };
+				_flusher.sync();
+				/* acknowledged once the data is written back */
+				return;
 			}
 
+			_session_metrics.record(packet.operation(), res_length, succeeded,
+			                        _metrics.now_us() - start_us);
+
 			packet.length(res_length);
 			packet.succeeded(succeeded);
 			tx_sink()->acknowledge_packet(packet);
@@ -150,11 +198,17 @@ class Lwext4_fs::Session_component : public File_system::Session_rpc_object
 
 		void _process_packets()
 		{
+			_ack_flushed_syncs();
+
 			while (tx_sink()->packet_avail()) {
 
 				if (!tx_sink()->ready_to_ack())
 					return;
 
+				/* resumed by 'flushed' */
+				if (_num_pending_syncs == MAX_PENDING_SYNCS)
+					return;
+
 				_process_packet();
 			}
 		}
@@ -170,24 +224,27 @@ class Lwext4_fs::Session_component : public File_system::Session_rpc_object
 		/**
 		 * Constructor
 		 */
-		Session_component(Genode::Env &env,
-		                  size_t       tx_buf_size,
-		                  char const  *root_dir,
-		                  bool         writeable,
-		                  Allocator   &md_alloc,
-		                  bool         report_stats)
+		Session_component(Genode::Env         &env,
+		                  size_t               tx_buf_size,
+		                  char const          *root_dir,
+		                  bool                 writeable,
+		                  Allocator           &md_alloc,
+		                  Metrics             &metrics,
+		                  Flusher             &flusher,
+		                  Session_label const &label)
 		:
 			Session_rpc_object(env.ram().alloc(tx_buf_size), env.rm(), env.ep().rpc_ep()),
 			_env(env),
 			_md_alloc(md_alloc),
 			_root(*new (&_md_alloc) Directory(root_dir, false)),
 			_writable(writeable),
-			_process_packet_handler(env.ep(), *this, &Session_component::_process_packets)
+			_process_packet_handler(env.ep(), *this, &Session_component::_process_packets),
+			_metrics(metrics),
+			_session_metrics(metrics.sessions, label),
+			_flusher(flusher)
 		{
 			_tx.sigh_packet_avail(_process_packet_handler);
 			_tx.sigh_ready_to_ack(_process_packet_handler);
-
-			_stats_reporter.enabled(report_stats);
 		}
 
 		/**
@@ -200,6 +257,31 @@ class Lwext4_fs::Session_component : public File_system::Session_rpc_object
 			destroy(&_md_alloc, &_root);
 		}
 
+		/*******************************
+		 ** Flusher::Client interface **
+		 *******************************/
+
+		void flushed(bool succeeded) override
+		{
+			for (unsigned i = 0; i < _num_pending_syncs; i++) {
+				Pending_sync &sync = _pending_syncs[i];
+				if (sync.flushed) { continue; }
+
+				sync.packet.length(0);
+				sync.packet.succeeded(succeeded);
+				sync.flushed = true;
+
+				_session_metrics.record(Packet_descriptor::SYNC, 0, succeeded,
+				                        _metrics.now_us() - sync.start_us);
+			}
+
+			/* the rest is acknowledged once the client is ready */
+			_ack_flushed_syncs();
+
+			if (tx_sink()->packet_avail())
+				Signal_transmitter(_process_packet_handler).submit();
+		}
+
 		/***************************
 		 ** File_system interface **
 		 ***************************/
@@ -509,11 +591,23 @@ class Lwext4_fs::Root : public Root_component<Session_component>
 
 		int _sessions { 0 };
 
-		bool _report_stats { false };
 		bool _verbose      { false };
 
 		Genode::Attached_rom_dataspace _config_rom { _env, "config" };
 
+		Metrics _metrics { _env };
+		Flusher _flusher { _env };
+
+		unsigned _report_interval_ms { 0 };
+
+		Constructible<Timer::Periodic_timeout<Root>> _report_timeout { };
+
+		void _report(Duration)
+		{
+			/* statistics are only available while mounted */
+			if (_sessions) { _metrics.update(); }
+		}
+
 		Genode::Signal_handler<Lwext4_fs::Root> _config_sigh {
 			_env.ep(), *this, &Lwext4_fs::Root::_handle_config_update };
 
@@ -527,10 +621,26 @@ class Lwext4_fs::Root : public Root_component<Session_component>
 
 			_verbose = config.attribute_value("verbose", false);
 
+			bool     report_stats = false;
+			unsigned interval_ms  = 0;
 			try {
-				_report_stats = config.sub_node("report")
-				                      .attribute_value("stats", false);
+				Genode::Xml_node report = config.sub_node("report");
+				report_stats = report.attribute_value("stats", false);
+				interval_ms  = report.attribute_value("interval_ms", 0U);
 			} catch (...) { }
+
+			_metrics.enabled(report_stats);
+			_flusher.configure(config);
+
+			/* without interval, the statistics are updated on sync */
+			if (!report_stats || !interval_ms) {
+				_report_timeout.destruct();
+			} else if (!_report_timeout.constructed()
+			        || interval_ms != _report_interval_ms) {
+				_report_timeout.construct(_metrics.timer(), *this, &Root::_report,
+				                          Microseconds(interval_ms*1000));
+			}
+			_report_interval_ms = interval_ms;
 		}
 
 
@@ -611,13 +721,14 @@ class Lwext4_fs::Root : public Root_component<Session_component>
 			try {
 				if (++_sessions == 1) {
 					File_system::mount_fs(_config_rom.xml());
+					_flusher.mounted = true;
 				}
 			} catch (...) { throw Service_denied(); }
 
 			try {
 				return new (md_alloc())
 					Session_component(_env, tx_buf_size, root_dir, writeable, *md_alloc(),
-					                  _report_stats);
+					                  _metrics, _flusher, label);
 
 			} catch (Lookup_failed) {
 				Genode::error("File system root directory \"", root_dir, "\" does not exist");
@@ -630,7 +741,10 @@ class Lwext4_fs::Root : public Root_component<Session_component>
 			Genode::destroy(md_alloc(), session);
 
 			try {
-				if (--_sessions == 0) { File_system::unmount_fs(); }
+				if (--_sessions == 0) {
+					_flusher.mounted = false;
+					File_system::unmount_fs();
+				}
 			} catch (...) { }
 		}
 
@@ -645,6 +759,9 @@ class Lwext4_fs::Root : public Root_component<Session_component>
 			Root_component<Session_component>(env.ep(), md_alloc),
 			_env(env)
 		{
+			_metrics.flush_stats = &_flusher.stats;
+			_flusher.observer    = &_metrics;
+
 			_config_rom.sigh(_config_sigh);
 			_handle_config_update();
 		}
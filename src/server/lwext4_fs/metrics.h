@@ -0,0 +1,230 @@
+/*
+ * \brief  Lwext4 file system metrics
+ * \author agent
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+/* Genode includes */
+#include <base/registry.h>
+#include <base/session_label.h>
+#include <file_system_session/file_system_session.h>
+#include <os/reporter.h>
+#include <timer_session/connection.h>
+#include <util/reconstructible.h>
+
+/* library includes */
+#include <lwext4/init.h>
+
+/* local includes */
+#include <file_system.h>
+#include <flusher.h>
+
+namespace Lwext4_fs {
+	using namespace Genode;
+
+	struct Latency_histogram;
+	struct Session_metrics;
+	struct Metrics;
+}
+
+
+/**
+ * Histogram with power-of-two buckets
+ */
+struct Lwext4_fs::Latency_histogram
+{
+	/* bucket i counts latencies below 2^i us, the last one all others */
+	enum { NUM_BUCKETS = 20 };
+
+	unsigned long buckets[NUM_BUCKETS] { };
+	unsigned long count  = 0;
+	uint64_t      sum_us = 0;
+	uint64_t      max_us = 0;
+
+	void record(uint64_t us)
+	{
+		unsigned i = 0;
+		while (i < NUM_BUCKETS - 1 && us >= (1ULL << i)) { ++i; }
+
+		++buckets[i];
+		++count;
+		sum_us += us;
+		max_us  = max(max_us, us);
+	}
+
+	void generate(Xml_generator &xml, char const *name) const
+	{
+		if (!count) { return; }
+
+		xml.node(name, [&] () {
+			xml.attribute("count",  count);
+			xml.attribute("avg_us", sum_us / count);
+			xml.attribute("max_us", max_us);
+
+			for (unsigned i = 0; i < NUM_BUCKETS; i++) {
+				if (!buckets[i]) { continue; }
+
+				xml.node("bucket", [&] () {
+					if (i < NUM_BUCKETS - 1)
+						xml.attribute("below_us", 1ULL << i);
+					else
+						xml.attribute("above_us", 1ULL << (i - 1));
+					xml.attribute("count", buckets[i]);
+				});
+			}
+		});
+	}
+};
+
+
+/**
+ * Operations performed on behalf of one session
+ */
+struct Lwext4_fs::Session_metrics
+{
+	typedef File_system::Packet_descriptor Packet_descriptor;
+
+	Session_label const label;
+
+	unsigned long reads  = 0;
+	unsigned long writes = 0;
+	unsigned long syncs  = 0;
+	unsigned long errors = 0;
+
+	uint64_t read_bytes    = 0;
+	uint64_t written_bytes = 0;
+
+	Latency_histogram read_latency  { };
+	Latency_histogram write_latency { };
+	Latency_histogram sync_latency  { };
+
+	Session_metrics(Session_label const &label) : label(label) { }
+
+	void record(Packet_descriptor::Opcode op, size_t bytes,
+	            bool succeeded, uint64_t latency_us)
+	{
+		if (!succeeded) { ++errors; }
+
+		switch (op) {
+		case Packet_descriptor::READ:
+			++reads;
+			read_bytes += bytes;
+			read_latency.record(latency_us);
+			break;
+		case Packet_descriptor::WRITE:
+			++writes;
+			written_bytes += bytes;
+			write_latency.record(latency_us);
+			break;
+		case Packet_descriptor::SYNC:
+			++syncs;
+			sync_latency.record(latency_us);
+			break;
+		default: break;
+		}
+	}
+
+	void generate(Xml_generator &xml) const
+	{
+		xml.node("session", [&] () {
+			xml.attribute("label",         label);
+			xml.attribute("reads",         reads);
+			xml.attribute("writes",        writes);
+			xml.attribute("syncs",         syncs);
+			xml.attribute("errors",        errors);
+			xml.attribute("read_bytes",    read_bytes);
+			xml.attribute("written_bytes", written_bytes);
+
+			read_latency .generate(xml, "read");
+			write_latency.generate(xml, "write");
+			sync_latency .generate(xml, "sync");
+		});
+	}
+};
+
+
+/**
+ * Metrics of all sessions and the file system
+ */
+struct Lwext4_fs::Metrics : Flusher::Observer
+{
+	typedef Registered<Session_metrics> Registered_session;
+
+	Env &_env;
+
+	/* the report grows with the number of sessions */
+	Constructible<Expanding_reporter> _reporter { };
+
+	Constructible<Timer::Connection> _timer { };
+
+	Registry<Registered_session> sessions { };
+
+	Flusher::Stats const *flush_stats = nullptr;
+
+	Metrics(Env &env) : _env(env) { }
+
+	void enabled(bool enabled)
+	{
+		if (enabled && !_timer.constructed()) { _timer.construct(_env); }
+
+		if (enabled && !_reporter.constructed())
+			_reporter.construct(_env, "file_system_stats", "stats");
+
+		if (!enabled) { _reporter.destruct(); }
+	}
+
+	bool enabled() const { return _reporter.constructed(); }
+
+	Timer::Connection &timer() { return *_timer; }
+
+	/**
+	 * Return time stamp for latency measurements, 0 if disabled
+	 */
+	uint64_t now_us()
+	{
+		return _timer.constructed()
+		       ? _timer->curr_time().trunc_to_plain_us().value : 0;
+	}
+
+	void update()
+	{
+		if (!enabled()) { return; }
+
+		Lwext4::Block_stats const &block = Lwext4::block_stats();
+
+		_reporter->generate([&] (Xml_generator &xml) {
+			File_system::stats_update(xml);
+
+			xml.node("block", [&] () {
+				xml.attribute("reads",           block.reads);
+				xml.attribute("writes",          block.writes);
+				xml.attribute("blocks_read",     block.blocks_read);
+				xml.attribute("blocks_written",  block.blocks_written);
+				xml.attribute("max_queue_depth", block.max_queue_depth);
+			});
+
+			if (flush_stats) { flush_stats->generate(xml); }
+
+			sessions.for_each([&] (Session_metrics const &session) {
+				session.generate(xml); });
+		});
+	}
+
+	/*********************************
+	 ** Flusher::Observer interface **
+	 *********************************/
+
+	void flush_completed() override { update(); }
+};
+
+#endif /* _METRICS_H_ */
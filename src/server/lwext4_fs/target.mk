@@ -10,3 +10,6 @@ CC_OPT += -DCONFIG_HAVE_OWN_ASSERT=1
 CC_OPT += -DCONFIG_BLOCK_DEV_CACHE_SIZE=256
 
 CC_CXX_WARN_STRICT =
+
+# count block-cache hits, misses, and evictions, see file_system.cc
+LD_OPT += --wrap=ext4_bcache_alloc --wrap=ext4_bcache_drop_buf
@@ -0,0 +1,423 @@
+/*
+ * \brief  Server that distributes one sample stream to several clients
+ * \author agent
+ * \date   2026-10-19
+ *
+ * Samples are read once from a Terminal or ROM source into a ring buffer
+ * and handed out to every Terminal client from its own read position.
+ * The source is only read as far as the slowest client permits, so all
+ * clients observe the very same stream.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <terminal_session/connection.h>
+#include <timer_session/connection.h>
+#include <root/component.h>
+#include <base/attached_ram_dataspace.h>
+#include <base/attached_rom_dataspace.h>
+#include <base/component.h>
+#include <base/registry.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <os/reporter.h>
+
+namespace Sample_tee {
+
+	using namespace Genode;
+
+	struct Source;
+	struct Terminal_source;
+	struct Rom_source;
+	class  Ring;
+	class  Session_component;
+	class  Root_component;
+	struct Main;
+
+	typedef Registered<Session_component> Registered_session;
+	typedef Registry<Registered_session>  Session_registry;
+}
+
+
+struct Sample_tee::Source
+{
+	/**
+	 * Read up to 'n' bytes, return number of bytes read
+	 */
+	virtual size_t fetch(char *dst, size_t n) = 0;
+};
+
+
+struct Sample_tee::Terminal_source : Source
+{
+	Terminal::Connection _terminal;
+
+	Terminal_source(Env &env, Signal_context_capability sigh)
+	: _terminal(env, "source")
+	{
+		_terminal.read_avail_sigh(sigh);
+	}
+
+	size_t fetch(char *dst, size_t n) override {
+		return _terminal.avail() ? _terminal.read(dst, n) : 0; }
+};
+
+
+struct Sample_tee::Rom_source : Source
+{
+	Attached_rom_dataspace _rom;
+
+	size_t _offset    = 0;
+	bool   _exhausted = false;
+
+	Rom_source(Env &env) : _rom(env, "samples") { }
+
+	size_t fetch(char *dst, size_t n) override
+	{
+		n = min(n, _rom.size() - _offset);
+		if (n == 0) {
+			if (!_exhausted)
+				warning("sample ROM exhausted after ", _offset, " bytes");
+			_exhausted = true;
+			return 0;
+		}
+		memcpy(dst, _rom.local_addr<char>() + _offset, n);
+		_offset += n;
+		return n;
+	}
+};
+
+
+/**
+ * Ring buffer indexed by absolute stream positions
+ */
+class Sample_tee::Ring
+{
+	private:
+
+		Attached_ram_dataspace _ds;
+
+		char  *const _buf      = _ds.local_addr<char>();
+		size_t const _capacity = _ds.size();
+
+		uint64_t _head = 0; /* stream position of the next byte to fetch */
+
+	public:
+
+		Ring(Env &env, size_t capacity) : _ds(env.ram(), env.rm(), capacity) { }
+
+		uint64_t head()     const { return _head; }
+		size_t   capacity() const { return _capacity; }
+
+		/**
+		 * Oldest stream position still held in the ring
+		 */
+		uint64_t tail() const {
+			return _head > _capacity ? _head - _capacity : 0; }
+
+		/**
+		 * Fetch from 'source' without overwriting data at or above 'keep'
+		 *
+		 * \return number of bytes fetched
+		 */
+		size_t fill(Source &source, uint64_t keep)
+		{
+			size_t total = 0;
+
+			while (_head - keep < _capacity) {
+				size_t const offset = _head % _capacity;
+				size_t const room   = min(_capacity - offset,
+				                          (size_t)(_capacity - (_head - keep)));
+
+				size_t const n = source.fetch(_buf + offset, room);
+				if (n == 0) break;
+
+				_head += n;
+				total += n;
+			}
+			return total;
+		}
+
+		/**
+		 * Copy data starting at stream position 'pos'
+		 */
+		size_t copy(char *dst, uint64_t pos, size_t n) const
+		{
+			n = min(n, (size_t)(_head - pos));
+
+			size_t const offset = pos % _capacity;
+			size_t const first  = min(n, _capacity - offset);
+
+			memcpy(dst, _buf + offset, first);
+			memcpy(dst + first, _buf, n - first);
+			return n;
+		}
+};
+
+
+class Sample_tee::Session_component : public Rpc_object<Terminal::Session, Session_component>
+{
+	public:
+
+		struct Stream
+		{
+			/**
+			 * Make samples at or above 'pos' available, return stream head
+			 */
+			virtual uint64_t fill(uint64_t pos) = 0;
+
+			virtual Ring const &ring() const = 0;
+
+			virtual void consumed() = 0;
+		};
+
+	private:
+
+		Attached_ram_dataspace _io_buffer;
+
+		Stream &_stream;
+
+		uint64_t _pos;
+
+		Signal_context_capability _read_avail_sigh { };
+
+		bool _waiting = false;
+
+	public:
+
+		Session_component(Env &env, Stream &stream, uint64_t pos)
+		:
+			_io_buffer(env.ram(), env.rm(), 0x1000),
+			_stream(stream), _pos(pos)
+		{ }
+
+		uint64_t pos() const { return _pos; }
+
+		/**
+		 * Notify the client if it ran out of data before
+		 */
+		void wake()
+		{
+			if (_waiting && _read_avail_sigh.valid()) {
+				_waiting = false;
+				Signal_transmitter(_read_avail_sigh).submit();
+			}
+		}
+
+		Dataspace_capability _dataspace() { return _io_buffer.cap(); }
+
+		size_t _read(size_t n)
+		{
+			n = min(n, _io_buffer.size());
+
+			uint64_t const head = _stream.fill(_pos);
+
+			if (head == _pos) {
+				_waiting = true;
+				return 0;
+			}
+
+			n = _stream.ring().copy(_io_buffer.local_addr<char>(), _pos, n);
+			_pos += n;
+
+			/* the client waits for a signal once it drained the stream */
+			if (_pos == head)
+				_waiting = true;
+
+			_stream.consumed();
+			return n;
+		}
+
+		size_t read(void *, size_t) override { return 0; }
+
+		size_t _write(size_t) { return 0; }
+		size_t write(void const *, size_t) override { return 0; }
+
+		Size size() override { return Size(0, 0); }
+
+		bool avail() override { return _stream.fill(_pos) > _pos; }
+
+		void connected_sigh(Signal_context_capability cap) override {
+			Signal_transmitter(cap).submit(); }
+
+		void read_avail_sigh(Signal_context_capability cap) override
+		{
+			_read_avail_sigh = cap;
+			_waiting = true;
+			wake();
+		}
+
+		void size_changed_sigh(Signal_context_capability) override { }
+};
+
+
+class Sample_tee::Root_component :
+	public Genode::Root_component<Sample_tee::Session_component>
+{
+	private:
+
+		Env                         &_env;
+		Session_registry            &_sessions;
+		Session_component::Stream   &_stream;
+
+	protected:
+
+		Session_component *_create_session(char const *) override
+		{
+			/* new clients start at the oldest sample still available */
+			return new (md_alloc())
+				Registered_session(_sessions, _env, _stream, _stream.ring().tail());
+		}
+
+	public:
+
+		Root_component(Env &env, Allocator &alloc, Session_registry &sessions,
+		               Session_component::Stream &stream)
+		:
+			Genode::Root_component<Session_component>(env.ep(), alloc),
+			_env(env), _sessions(sessions), _stream(stream)
+		{ }
+};
+
+
+struct Sample_tee::Main : Session_component::Stream
+{
+	Env &_env;
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Sliced_heap _session_heap { _env.ram(), _env.rm() };
+
+	Session_registry _sessions { };
+
+	Signal_handler<Main> _source_handler {
+		_env.ep(), *this, &Main::_handle_source };
+
+	Constructible<Terminal_source> _terminal_source { };
+	Constructible<Rom_source>      _rom_source      { };
+
+	Source &_init_source()
+	{
+		typedef String<16> Type;
+		if (_config.xml().attribute_value("source", Type("terminal")) == "rom") {
+			_rom_source.construct(_env);
+			return *_rom_source;
+		}
+		_terminal_source.construct(_env, _source_handler);
+		return *_terminal_source;
+	}
+
+	Source &_source = _init_source();
+
+	enum { DEFAULT_RING_SIZE = 1024*1024 };
+
+	Ring _ring { _env, _config.xml().attribute_value("ring_size",
+	                   Number_of_bytes(DEFAULT_RING_SIZE)) };
+
+	/* counters */
+	unsigned long _stalls = 0; /* fills prevented by the slowest client */
+
+	/**
+	 * Stream position of the slowest client
+	 */
+	uint64_t _slowest()
+	{
+		uint64_t pos = _ring.head();
+		_sessions.for_each([&] (Session_component &s) {
+			pos = min(pos, s.pos()); });
+		return pos;
+	}
+
+	void _wake_all()
+	{
+		_sessions.for_each([&] (Session_component &s) { s.wake(); });
+	}
+
+	void _handle_source()
+	{
+		if (_ring.fill(_source, _slowest()))
+			_wake_all();
+	}
+
+	/* Stream interface */
+
+	uint64_t fill(uint64_t pos) override
+	{
+		if (pos < _ring.head())
+			return _ring.head();
+
+		uint64_t const keep = _slowest();
+		if (_ring.head() - keep == _ring.capacity())
+			_stalls++;
+		else if (_ring.fill(_source, keep))
+			_wake_all();
+
+		return _ring.head();
+	}
+
+	Ring const &ring() const override { return _ring; }
+
+	void consumed() override
+	{
+		/* the slowest client may have made room for the others */
+		if (_ring.head() - _slowest() < _ring.capacity())
+			_wake_all();
+	}
+
+	/* statistics */
+
+	Reporter _reporter { _env, "sample_tee" };
+
+	Constructible<Timer::Connection> _timer { };
+
+	Signal_handler<Main> _report_handler {
+		_env.ep(), *this, &Main::_handle_report };
+
+	uint64_t _reported_head = 0;
+	unsigned _report_ms     = 0;
+
+	void _handle_report()
+	{
+		uint64_t const head = _ring.head();
+
+		unsigned clients = 0;
+		_sessions.for_each([&] (Session_component &) { clients++; });
+
+		Reporter::Xml_generator xml(_reporter, [&] () {
+			xml.attribute("bytes",       head);
+			xml.attribute("bytes_per_s", ((head - _reported_head)*1000) / _report_ms);
+			xml.attribute("clients",     clients);
+			xml.attribute("lag",         head - _slowest());
+			xml.attribute("stalls",      _stalls);
+		});
+
+		_reported_head = head;
+	}
+
+	Root_component _root { _env, _session_heap, _sessions, *this };
+
+	Main(Env &env) : _env(env)
+	{
+		_report_ms = _config.xml().attribute_value("report_ms", 0U);
+		if (_report_ms) {
+			_reporter.enabled(true);
+			_timer.construct(_env);
+			_timer->sigh(_report_handler);
+			_timer->trigger_periodic(_report_ms*1000UL);
+		}
+
+		_env.parent().announce(_env.ep().manage(_root));
+	}
+};
+
+
+void Component::construct(Genode::Env &env)
+{
+	static Sample_tee::Main inst(env);
+}
@@ -0,0 +1,3 @@
+TARGET := sample_tee
+SRC_CC := component.cc
+LIBS   := base
@@ -12,69 +12,7 @@ extern "C"
 #include <keynote/keynote.h>
 #include <keynote/header.h>
 }
-char policy_assertions[] = 
-"Authorizer: \"POLICY\"\n" \
-"Licensees: D1\n"\
-"Local-Constants: \n" \
-"     D1 = \"rsa-hex:3048024100d15d08ce7d2103d93ef21a87330361\\\n" \
-"             ff123096b14330f9f0936e8f2064ef815ffdaabbb7d3ba47b\\\n" \
-"             49fac090cf44818af7ac7d66c2910f32d8d5eb261328558e1\\\n" \
-"             0203010001\"\n" \
-"Comment: This is our first policy assertion\n" \
-"Conditions: app_domain == \"test application\" -> \"true\";\n" \
-"\n" \
-"Authorizer: \"POLICY\"\n" \
-"Licensees: KEY1 || KEY2\n" \
-"Local-Constants: \n" \
-"     KEY1 = \"rsa-base64:MEgCQQCzxWCi619s3Bqf8QOZTREBFelqWvljw\\\n" \
-"              vCwktO7/5zufcz+P0UBRBFNtasWgkP6/tAIK8MnLMUnejGsye\\\n" \
-"              DS2EVzAgMBAAE=\"\n" \
-"     KEY2 = \"dsa-base64:MIHfAkEAhRzwrvhbRXIJH+nGfQB/tRp3ueF0j\\\n" \
-"              4OqVU4GmC6eIlrmlKxR+Me6tjqtWJr5gf/AEOnzoQAPRIlpiP\\\n" \
-"              VJX1mRjwJBAKHTpHS7M938wVr+lIMjq0H0Aav5T4jlxS2rphI\\\n" \
-"              4fbc7tJm6wPW9p2KyHbe9GaZgzYK1OdnNXdanM/AkLW4OKz0C\\\n" \
-"              FQDF69A/EHKoQC1H6DxCi0L3HfW9uwJANCLE6ViRxnv4Jj0gV\\\n" \
-"              8aO/b5AD+uA63+0EXUxO0Hqp91lzhDg/61BusMxFq7mQI0CLv\\\n" \
-"              S+dlCGShsYyB+VjSub7Q==\"\n" \
-"Comment: A slightly more complicated policy\n" \
-"Conditions: app_domain == \"test application\" && @some_num == 1 && \n" \
-"            (some_var == \"some value\" || \n" \
-"             some_var == \"some other value\") -> \"true\";";
-
-char credential_assertions[] =
-"KeyNote-Version: 2\n"\
-"Authorizer: KEY1\n"
-"Local-Constants: \n" \
-"     KEY1 = \"rsa-base64:MEgCQQCzxWCi619s3Bqf8QOZTREBFelqWvljw\\\n" \
-"              vCwktO7/5zufcz+P0UBRBFNtasWgkP6/tAIK8MnLMUnejGsye\\\n" \
-"              DS2EVzAgMBAAE=\"\n" \
-"Licensees: \"dsa-hex:3081de02402121e160209f7ecef1b6866c907e8d\\\n" \
-"             d65e9a67ef0fbd6ece7760b7c8bb0d9a0b71a0dd921b949f0\\\n" \
-"             9a16092eb3f50e33892bc3e9f1c8409f5298de40461493ef1\\\n" \
-"             024100a60b7e77f317e156566b388aaa32c3866a086831649\\\n" \
-"             1a55ab6fb8e57f7ade4a2a31e43017c383ab2a3e54f49688d\\\n" \
-"             d66a326b7362beb974f2f1fb7dd573dd1bdf021500909807a\\\n" \
-"             4937f198fe893be6c63a7d627f13a385b02405811292c9949\\\n" \
-"             7aa80911c781a0ff51a5843423b9b4d03ad7e708ae2bfacaf\\\n" \
-"             11477f4f197dbba534194f8afd1e0b73261bb0a2c04af35db\\\n" \
-"             0507f5cffe74ed4f1a\"\n" \
-"Conditions: app_domain == \"test application\" && \n" \
-"            another_var == \"foo\" -> \"true\";\n" \
-"Signature: \"sig-rsa-sha1-base64:E2OhrczI0LtAYAoJ6fSlqvlQDA4r\\\n" \
-"            GiIX73T6p9eExpyHZbfjxPxXEIf6tbBre6x2Y26wBQCx/yCj5\\\n" \
-"            4IS3tuY2w==\"\n";
-
-char action_authorizer[] = 
-"dsa-hex:3081de02402121e160209f7ecef1b6866c907e8d" \
-"d65e9a67ef0fbd6ece7760b7c8bb0d9a0b71a0dd921b949f0" \
-"9a16092eb3f50e33892bc3e9f1c8409f5298de40461493ef1" \
-"024100a60b7e77f317e156566b388aaa32c3866a086831649" \
-"1a55ab6fb8e57f7ade4a2a31e43017c383ab2a3e54f49688d" \
-"d66a326b7362beb974f2f1fb7dd573dd1bdf021500909807a" \
-"4937f198fe893be6c63a7d627f13a385b02405811292c9949" \
-"7aa80911c781a0ff51a5843423b9b4d03ad7e708ae2bfacaf" \
-"11477f4f197dbba534194f8afd1e0b73261bb0a2c04af35db" \
-"0507f5cffe74ed4f1a";
+#include "assertions.h"
 
 #define NUM_RETURN_VALUES 2
 
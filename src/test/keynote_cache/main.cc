@@ -0,0 +1,131 @@
+/*
+ * \brief  Benchmark of KeyNote queries with and without session reuse
+ * \author agent
+ * \date   2026-10-19
+ *
+ * The cold benchmark opens a new KeyNote session for every query, which
+ * parses the assertions and verifies the credential signature each time.
+ * The warm benchmark sends the same queries through one session cache.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <libc/component.h>
+#include <base/attached_rom_dataspace.h>
+#include <timer_session/connection.h>
+#include <keynote/session_cache.h>
+#include <base/log.h>
+
+/* libc includes */
+#include <stdlib.h>
+
+extern "C" {
+#include <keynote/keynote.h>
+}
+
+#include "assertions.h"
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Main;
+
+	static Keynote::Action const actions[] = {
+		{ "app_domain",  "test application" },
+		{ "some_num",    "1" },
+		{ "some_var",    "some other value" },
+		{ "another_var", "foo" },
+	};
+
+	enum { NUM_ACTIONS = sizeof(actions)/sizeof(actions[0]) };
+}
+
+
+struct Test::Main
+{
+	Libc::Env &_env;
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Timer::Connection _timer { _env };
+
+	unsigned const _rounds =
+		_config.xml().attribute_value("rounds", 200U);
+
+	char *_return_values[2] { (char *)"false", (char *)"true" };
+
+	int _query(Keynote::Session_cache &cache)
+	{
+		return cache.query(policy_assertions, credential_assertions,
+		                   action_authorizer, actions, NUM_ACTIONS,
+		                   _return_values, 2);
+	}
+
+	void _report(char const *name, unsigned long ms)
+	{
+		unsigned long const qps = ms ? (_rounds*1000UL)/ms : 0;
+		log(name, ": ", _rounds, " queries in ", ms, " ms, ", qps, " queries/s");
+	}
+
+	int run()
+	{
+		/* reference result from a fresh session */
+		int expected = -1;
+		{
+			Keynote::Session_cache cache(1);
+			expected = _query(cache);
+		}
+		if (expected < 0) {
+			error("query failed, keynote_errno=", keynote_errno);
+			return -1;
+		}
+		log("query result: ", Cstring(_return_values[expected]));
+
+		/* cold: parse and verify all assertions for every query */
+		unsigned long start = _timer.elapsed_ms();
+		for (unsigned i = 0; i < _rounds; i++) {
+			Keynote::Session_cache cache(1);
+			if (_query(cache) != expected) {
+				error("cold query ", i, " returned a different result");
+				return -1;
+			}
+		}
+		unsigned long const cold_ms = _timer.elapsed_ms() - start;
+
+		/* warm: the assertions are parsed and verified once */
+		Keynote::Session_cache cache;
+		start = _timer.elapsed_ms();
+		for (unsigned i = 0; i < _rounds; i++) {
+			if (_query(cache) != expected) {
+				error("warm query ", i, " returned a different result");
+				return -1;
+			}
+		}
+		unsigned long const warm_ms = _timer.elapsed_ms() - start;
+
+		_report("cold", cold_ms);
+		_report("warm", warm_ms);
+
+		Keynote::Session_cache::Stats const stats = cache.stats();
+		log("cache hits=", stats.hits, " misses=", stats.misses,
+		    " evictions=", stats.evictions);
+		return 0;
+	}
+
+	Main(Libc::Env &env) : _env(env) { }
+};
+
+
+void Libc::Component::construct(Libc::Env &env)
+{
+	static Test::Main main(env);
+
+	Libc::with_libc([&] () { exit(main.run()); });
+}
@@ -0,0 +1,7 @@
+TARGET = test-keynote_cache
+LIBS   = libc keynote libm
+SRC_CC = main.cc
+
+INC_DIR += $(PRG_DIR)/../keynote
+
+CC_CXX_WARN_STRICT =
@@ -0,0 +1,130 @@
+/*
+ * \brief  PCM conversion test and micro-benchmark
+ * \author agent
+ * \date   2026-10-19
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <world/pcm_convert.h>
+#include <audio_out_session/audio_out_session.h>
+#include <timer_session/connection.h>
+#include <base/component.h>
+#include <base/log.h>
+
+using namespace Genode;
+
+namespace Test {
+
+	enum {
+		FRAMES     = Audio_out::PERIOD,
+		ROUNDS     = 1 << 16,
+		ODD_FRAMES = FRAMES - 3,
+	};
+
+	struct Main;
+}
+
+
+struct Test::Main
+{
+	Env &_env;
+
+	Timer::Connection _timer { _env };
+
+	int16_t _s16[FRAMES*2];
+	float   _f32[FRAMES*2];
+
+	float _left[FRAMES],     _right[FRAMES];
+	float _ref_left[FRAMES], _ref_right[FRAMES];
+
+	bool _compare(char const *what, size_t frames)
+	{
+		for (size_t i = 0; i < frames; ++i) {
+			if (_left[i] != _ref_left[i] || _right[i] != _ref_right[i]) {
+				error(what, ": mismatch at frame ", i);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Run 'fn' ROUNDS times and log the conversion throughput
+	 */
+	template <typename FN>
+	void _measure(char const *what, FN const &fn)
+	{
+		unsigned long const start_ms = _timer.elapsed_ms();
+		for (unsigned i = 0; i < ROUNDS; ++i) {
+			fn();
+			/* prevent the compiler from hoisting the conversion */
+			asm volatile ("" : : "r" (_left), "r" (_right) : "memory");
+		}
+		unsigned long const ms = max(_timer.elapsed_ms() - start_ms, 1UL);
+
+		unsigned long long const frames = (unsigned long long)ROUNDS*FRAMES;
+		log(what, ": ", ms, " ms, ",
+		    (frames / ms) / 1000, " Mframes/s, ",
+		    (ms * 1000000ULL) / ROUNDS, " ns/period");
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- PCM conversion test started ---");
+
+		/* deterministic pseudo-random input including the extremes */
+		uint32_t seed = 0x1234567;
+		for (unsigned i = 0; i < FRAMES*2; ++i) {
+			seed = seed*1103515245 + 12345;
+			_s16[i] = (int16_t)(seed >> 16);
+			_f32[i] = (float)_s16[i] / 32768.0f;
+		}
+		_s16[0] = -32768;
+		_s16[1] =  32767;
+
+		bool ok = true;
+
+		size_t const frame_counts[] = { FRAMES, ODD_FRAMES };
+		for (size_t const frames : frame_counts) {
+			Pcm::s16_to_planar(_left, _right, _s16, frames, 0.75f);
+			Pcm::Scalar::s16_to_planar(_ref_left, _ref_right, _s16, frames, 0.75f);
+			ok &= _compare("s16", frames);
+
+			Pcm::f32_to_planar(_left, _right, _f32, frames, 0.75f);
+			Pcm::Scalar::f32_to_planar(_ref_left, _ref_right, _f32, frames, 0.75f);
+			ok &= _compare("f32", frames);
+		}
+
+		if (!ok) {
+			env.parent().exit(~0);
+			return;
+		}
+
+#ifdef PCM_CONVERT_VECTOR
+		log("vector kernels enabled");
+#else
+		log("vector kernels not available, measuring scalar code only");
+#endif
+
+		_measure("s16 scalar", [&] () {
+			Pcm::Scalar::s16_to_planar(_left, _right, _s16, FRAMES, 0.5f); });
+		_measure("s16       ", [&] () {
+			Pcm::s16_to_planar(_left, _right, _s16, FRAMES, 0.5f); });
+		_measure("f32 scalar", [&] () {
+			Pcm::Scalar::f32_to_planar(_left, _right, _f32, FRAMES, 0.5f); });
+		_measure("f32       ", [&] () {
+			Pcm::f32_to_planar(_left, _right, _f32, FRAMES, 0.5f); });
+
+		log("--- PCM conversion test finished ---");
+		env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
@@ -0,0 +1,3 @@
+TARGET = test-pcm_convert
+SRC_CC = main.cc
+LIBS   = base
@@ -1,5 +1,5 @@
 /*
- * \brief  RDRAND test
+ * \brief  RDRAND test and benchmark
  * \author Emery Hemingway
  * \date   2019-02-05
  */
@@ -12,11 +12,46 @@
  */
 
 #include <world/rdrand.h>
+#include <timer_session/connection.h>
 #include <base/component.h>
 #include <base/log.h>
 
 using namespace Genode;
 
+
+/**
+ * Fill a buffer repeatedly for a while and log the throughput
+ *
+ * \param fill  function filling a buffer and counting retries
+ */
+template <typename FN>
+static void benchmark(Timer::Connection &timer, char const *name, FN const &fill)
+{
+	enum { BUFFER_SIZE = 4096, DURATION_MS = 1000 };
+
+	static uint64_t buf[BUFFER_SIZE / sizeof(uint64_t)];
+
+	unsigned long retries = 0;
+	unsigned long rounds  = 0;
+
+	unsigned long const start_ms = timer.elapsed_ms();
+	unsigned long       elapsed_ms;
+
+	do {
+		fill(buf, sizeof(buf), retries);
+		rounds++;
+		elapsed_ms = timer.elapsed_ms() - start_ms;
+	} while (elapsed_ms < DURATION_MS);
+
+	uint64_t const bytes = (uint64_t)rounds * BUFFER_SIZE;
+	uint64_t const words = bytes / sizeof(uint64_t);
+
+	log(name, ": ", bytes / 1024, " KiB in ", elapsed_ms, " ms, ",
+	    (bytes * 1000 / elapsed_ms) / 1024, " KiB/s, ",
+	    retries, " retries (", (retries * 1000000) / words, " per million words)");
+}
+
+
 void Component::construct(Genode::Env &env)
 {
 	log("--- RDRAND test started ---");
@@ -36,6 +71,27 @@ void Component::construct(Genode::Env &env)
 			error("RDRAND returned only 32 bits of entropy");
 			env.parent().exit(~0);
 		}
+
+		/* an unaligned fill must not touch bytes beyond the buffer */
+		{
+			unsigned char buf[16] { };
+			Rdrand::fill(buf + 1, 13);
+			if (buf[0] || buf[14] || buf[15]) {
+				error("RDRAND fill exceeded its buffer");
+				env.parent().exit(~0);
+			}
+		}
+
+		Timer::Connection timer(env);
+
+		benchmark(timer, "RDRAND", [] (void *dst, size_t len, unsigned long &retries) {
+			Rdrand::fill(dst, len, retries); });
+
+		if (Rdrand::seed_supported())
+			benchmark(timer, "RDSEED", [] (void *dst, size_t len, unsigned long &retries) {
+				Rdrand::fill_seed(dst, len, retries); });
+		else
+			log("RDSEED instruction not supported");
 	}
 
 	log("--- RDRAND test finished ---");
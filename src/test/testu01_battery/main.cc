@@ -0,0 +1,177 @@
+/*
+ * \brief  Apply a TestU01 battery to a Terminal sample stream
+ * \author agent
+ * \date   2026-10-19
+ *
+ * TestU01 keeps the results of a battery in global variables, hence
+ * batteries cannot run concurrently within one component. Instead, one
+ * instance of this component is started per battery, and all instances
+ * read the same stream from a 'sample_tee' server.
+ */
+
+#include <testu01/genode_init.h>
+
+#include <terminal_session/connection.h>
+#include <base/attached_rom_dataspace.h>
+#include <libc/component.h>
+#include <os/reporter.h>
+#include <base/heap.h>
+#include <base/log.h>
+
+extern "C" {
+#include "unif01.h"
+#include "gofw.h"
+#include "bbattery.h"
+}
+
+/* This is a big one */
+Genode::size_t Libc::Component::stack_size() { return 64*1024*sizeof(Genode::addr_t); }
+
+
+namespace Testu01_battery {
+
+	using namespace Genode;
+
+	struct Stream;
+
+	static Stream *stream;
+}
+
+
+/**
+ * Blocking reader of 32-bit samples from the Terminal session
+ */
+struct Testu01_battery::Stream
+{
+	Terminal::Connection _terminal;
+
+	Signal_receiver _sig_rec { };
+	Signal_context  _sig_ctx { };
+
+	enum { BUFFER_SIZE = 4096 };
+
+	char   _buf[BUFFER_SIZE];
+	size_t _len  = 0; /* number of valid bytes in '_buf' */
+	size_t _next = 0; /* offset of the next sample */
+
+	unsigned long long samples = 0;
+
+	Stream(Env &env) : _terminal(env)
+	{
+		_terminal.read_avail_sigh(_sig_rec.manage(&_sig_ctx));
+	}
+
+	~Stream() { _sig_rec.dissolve(&_sig_ctx); }
+
+	unsigned next()
+	{
+		while (_len - _next < sizeof(unsigned)) {
+
+			/* keep the bytes of an incomplete sample for the next read */
+			size_t const rest = _len - _next;
+			Genode::memmove(_buf, _buf + _next, rest);
+			_len  = rest;
+			_next = 0;
+
+			size_t const n = _terminal.read(_buf + _len, sizeof(_buf) - _len);
+			if (n) {
+				_len += n;
+				continue;
+			}
+
+			/* wait until the server has more samples */
+			_sig_rec.wait_for_signal();
+		}
+
+		unsigned sample;
+		Genode::memcpy(&sample, _buf + _next, sizeof(sample));
+		_next += sizeof(sample);
+
+		++samples;
+		return sample;
+	}
+};
+
+
+static unsigned int stream_bits(void) {
+	return Testu01_battery::stream->next(); }
+
+
+void Libc::Component::construct(Libc::Env &env)
+{
+	using namespace Genode;
+	using namespace Testu01_battery;
+
+	Attached_rom_dataspace config_rom(env, "config");
+	Xml_node const config = config_rom.xml();
+
+	enum {
+		    MIN_NBITS = 500,
+		DEFAULT_NBITS = 1U << 20
+	};
+
+	typedef String<32> Name;
+
+	Name const battery = config.attribute_value("battery", Name());
+	unsigned const nbits = max((unsigned)MIN_NBITS,
+	                           config.attribute_value("nbits", (unsigned)DEFAULT_NBITS));
+
+	if (battery != "small_crush" && battery != "rabbit" && battery != "alphabit") {
+		error("'battery' must be one of 'small_crush', 'rabbit', or 'alphabit'");
+		env.parent().exit(~0);
+		return;
+	}
+
+	Heap heap(env.pd(), env.rm());
+	Timer::Connection timer(env);
+
+	testu01_init(heap, timer);
+
+	static Stream sample_stream(env);
+	stream = &sample_stream;
+
+	Reporter reporter(env, "results");
+	reporter.enabled(true);
+
+	unsigned long const start_ms = timer.elapsed_ms();
+
+	Libc::with_libc([&] () {
+		unif01_Gen *gen = unif01_CreateExternGenBits((char *)"sample_tee", stream_bits);
+
+		if (battery == "small_crush") bbattery_SmallCrush(gen);
+		if (battery == "rabbit")      bbattery_Rabbit(gen, nbits);
+		if (battery == "alphabit")    bbattery_Alphabit(gen, nbits, 0, 32);
+
+		unif01_DeleteExternGenBits(gen);
+	});
+
+	unsigned long const duration_ms = max(1UL, timer.elapsed_ms() - start_ms);
+
+	/* p-values outside [suspect, 1 - suspect] count as failures */
+	auto passed = [&] (double p) {
+		return p >= gofw_Suspectp && p <= 1.0 - gofw_Suspectp; };
+
+	unsigned failures = 0;
+	for (int i = 0; i < bbattery_NTests; ++i)
+		if (!passed(bbattery_pVal[i])) ++failures;
+
+	Reporter::Xml_generator xml(reporter, [&] () {
+		xml.attribute("battery",       battery);
+		xml.attribute("samples",       sample_stream.samples);
+		xml.attribute("duration_ms",   duration_ms);
+		xml.attribute("samples_per_s", (sample_stream.samples*1000) / duration_ms);
+		xml.attribute("tests",         bbattery_NTests);
+		xml.attribute("failures",      failures);
+
+		for (int i = 0; i < bbattery_NTests; ++i) {
+			xml.node("test", [&] () {
+				xml.attribute("name", bbattery_TestNames[i]);
+				xml.attribute("p",    String<32>(bbattery_pVal[i]));
+				xml.attribute("pass", passed(bbattery_pVal[i]));
+			});
+		}
+	});
+
+	/* failures are part of the report, not an error of the component */
+	env.parent().exit(0);
+}
@@ -0,0 +1,5 @@
+TARGET = testu01_battery
+LIBS  += testu01 libc libm
+SRC_CC = main.cc
+
+CC_CXX_WARN_STRICT =